@@ -0,0 +1,25 @@
+/*
+ * Example strategy plugin: Always guesses the lowest remaining solution.
+ * Build: cc -std=c99 -shared -fPIC -Isrc examples/first_solution.c -o first_solution.so
+ *        Add -DMM_CODE_64 if the executable was built with CODE64=1, plugins of another code width are rejected
+ * Run:   ./bin/release/Mastermind --arena knuth ./first_solution.so
+ */
+#include "strategy.h"
+
+static Code_t choose(void *state, MM_Match *match)
+{
+    (void)state;
+    Code_t guess = 0;
+    while (!mm_is_in_solution(match, guess))
+    {
+        guess++;
+    }
+    return guess;
+}
+
+static const Strategy strategy = { "first-solution", NULL, choose, NULL, STRAT_CODE_SIZE };
+
+const Strategy *mm_strategy_entry(int abi_version)
+{
+    return (abi_version == STRAT_ABI_VERSION) ? &strategy : NULL;
+}
@@ -0,0 +1,248 @@
+#define _DEFAULT_SOURCE
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <readline/readline.h>
+
+#include "analysis.h"
+#include "recommend.h"
+#include "util/console.h"
+#include "util/string_builder.h"
+
+/*
+ * Analysis of a guess against the solutions that were possible before it: How it split them
+ * and how much information it gave, compared with the best guess found. Runs on a background thread,
+ * if it is not ready after a short wait, it is printed while the player enters the next guess.
+ * If the next guess is entered first, the analysis is canceled and its output is dropped.
+ */
+
+#define WAIT_MS   30   // Longest delay of the prompt
+#define BUDGET_MS 1000 // For the search of the best guess
+
+typedef struct
+{
+    MM_Match *match; // Copy of the match before the guess
+    Code_t guess;
+    Feedback_t feedback;
+    StringBuilder text;
+    int canceled;   // Set when the analysis is superseded, stops the search of the best guess
+    bool done;      // Protected by mutex
+    bool abandoned; // Protected by mutex, the worker frees the analysis when it is done
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+} Analysis;
+
+static Analysis *current = NULL; // Analysis has been started but not printed yet
+
+static void free_analysis(Analysis *analysis)
+{
+    strb_destroy(&analysis->text);
+    mm_free_match(analysis->match);
+    pthread_mutex_destroy(&analysis->mutex);
+    pthread_cond_destroy(&analysis->cond);
+    free(analysis);
+}
+
+// Marks analysis as done, frees it if it has been abandoned
+static void finish_analysis(Analysis *analysis)
+{
+    pthread_mutex_lock(&analysis->mutex);
+    analysis->done = true;
+    bool abandoned = analysis->abandoned;
+    pthread_cond_signal(&analysis->cond);
+    pthread_mutex_unlock(&analysis->mutex);
+    if (abandoned)
+    {
+        free_analysis(analysis);
+    }
+}
+
+static void *run_analysis(void *arg)
+{
+    Analysis *analysis  = arg;
+    MM_Context *ctx     = mm_get_context(analysis->match);
+    int num_feedbacks   = mm_get_num_feedbacks(ctx);
+    CodeSize_t num_sols = mm_get_remaining_solutions(analysis->match);
+
+    // One-pass partition of the guess, solutions are only materialized once some are ruled out
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+    if (num_sols == mm_get_num_codes(ctx))
+    {
+        mm_get_partition_range(ctx, analysis->guess, 0, num_sols, counts);
+    }
+    else
+    {
+        Code_t *solutions = malloc(num_sols * sizeof(Code_t));
+        if (solutions == NULL)
+        {
+            strb_append(&analysis->text, "Not enough memory to analyze the guess");
+            finish_analysis(analysis);
+            return NULL;
+        }
+        mm_get_solutions(analysis->match, solutions);
+        mm_get_partition(ctx, analysis->guess, solutions, num_sols, counts);
+        free(solutions);
+    }
+
+    double bits     = -rec_score_partition(REC_ENTROPY, num_sols, num_feedbacks, counts);
+    double gained   = log2((double)num_sols / counts[analysis->feedback]);
+    CodeSize_t size = (CodeSize_t)rec_score_partition(REC_WORST_CASE, num_sols, num_feedbacks, counts);
+    int num_parts   = (int)-rec_score_partition(REC_MOST_PARTS, num_sols, num_feedbacks, counts);
+
+    strb_append(&analysis->text,
+                "Split %" PRIu64 " solutions into %d parts (largest %" PRIu64 "), %.2f bits expected, %.2f bits gained",
+                (uint64_t)num_sols,
+                num_parts,
+                (uint64_t)size,
+                bits,
+                gained);
+
+    RecScore best;
+    if (rec_get_top_k(analysis->match, REC_ENTROPY, BUDGET_MS, &analysis->canceled, 1, &best) == 1)
+    {
+        char *colors = get_colors_string(ctx, best.guess);
+        strb_append(&analysis->text,
+                    "\nBest guess found: %.2f bits expected (largest %" PRIu64 ")%s",
+                    -best.score,
+                    (uint64_t)best.worst_case,
+                    colors);
+        free(colors);
+    }
+
+    finish_analysis(analysis);
+    return NULL;
+}
+
+static bool is_done()
+{
+    pthread_mutex_lock(&current->mutex);
+    bool result = current->done;
+    pthread_mutex_unlock(&current->mutex);
+    return result;
+}
+
+static void finish()
+{
+    pthread_join(current->thread, NULL);
+    printf("%s\n", strb_to_str(&current->text));
+    free_analysis(current);
+    current = NULL;
+}
+
+// Cancels the current analysis without waiting for it, the worker frees it once it has stopped
+static void abandon()
+{
+    __atomic_store_n(&current->canceled, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&current->mutex);
+    bool done          = current->done;
+    pthread_t thread   = current->thread;
+    current->abandoned = !done;
+    pthread_mutex_unlock(&current->mutex);
+
+    if (done)
+    {
+        pthread_join(thread, NULL);
+        free_analysis(current);
+    }
+    else
+    {
+        pthread_detach(thread);
+    }
+    current       = NULL;
+    rl_event_hook = NULL;
+}
+
+// Called by readline while it waits for input, prints analysis above prompt when ready
+static int print_when_ready()
+{
+    if ((current != NULL) && is_done())
+    {
+        printf("\r\x1b[2K");
+        finish();
+        rl_on_new_line();
+        rl_redisplay();
+        rl_event_hook = NULL;
+    }
+    return 0;
+}
+
+/*
+ * Summary: Starts analysis of guess on a background thread, must be called before the match is constrained by it.
+ *     An analysis of the previous guess that is still running is canceled, so that the prompt is never delayed.
+ */
+void an_start(MM_Match *match, Code_t guess, Feedback_t feedback)
+{
+    if (current != NULL)
+    {
+        abandon();
+    }
+    if (!mm_is_enumerable(mm_get_context(match)) || !mm_is_solution_counting_enabled(match)
+        || (mm_get_remaining_solutions(match) == 0))
+    {
+        return;
+    }
+
+    current  = malloc(sizeof(Analysis));
+    *current = (Analysis){ .match     = mm_copy_match(match),
+                           .guess     = guess,
+                           .feedback  = feedback,
+                           .text      = strb_create(),
+                           .canceled  = 0,
+                           .done      = false,
+                           .abandoned = false };
+    pthread_mutex_init(&current->mutex, NULL);
+    pthread_cond_init(&current->cond, NULL);
+    if (pthread_create(&current->thread, NULL, run_analysis, current) != 0)
+    {
+        // Running it on this thread would delay the prompt, so the guess is not analyzed
+        free_analysis(current);
+        current = NULL;
+    }
+}
+
+// Prints the started analysis if it is ready in time, otherwise it is printed above the next prompt when ready
+void an_print()
+{
+    if (current == NULL)
+    {
+        return;
+    }
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_nsec += WAIT_MS * 1000000L;
+    timeout.tv_sec  += timeout.tv_nsec / 1000000000L;
+    timeout.tv_nsec %= 1000000000L;
+
+    int status = 0;
+    pthread_mutex_lock(&current->mutex);
+    while (!current->done && (status == 0))
+    {
+        status = pthread_cond_timedwait(&current->cond, &current->mutex, &timeout);
+    }
+    bool done = current->done;
+    pthread_mutex_unlock(&current->mutex);
+
+    if (done)
+    {
+        finish();
+    }
+    else
+    {
+        rl_event_hook = print_when_ready;
+    }
+}
+
+// Prints pending analysis, waits for it if necessary
+void an_wait()
+{
+    if (current != NULL)
+    {
+        rl_event_hook = NULL;
+        finish();
+    }
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "mastermind.h"
+
+void an_start(MM_Match *match, Code_t guess, Feedback_t feedback);
+void an_print();
+void an_wait();
@@ -0,0 +1,288 @@
+#define _DEFAULT_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <readline/readline.h>
+
+#include "assistant.h"
+#include "mastermind.h"
+#include "recommend.h"
+#include "util/console.h"
+#include "util/hash_map.h"
+#include "util/table.h"
+#include "util/timer.h"
+
+/*
+ * Codebreaker assistant for games on a physical board: The user enters each guess played and the feedback
+ * given by the codemaker, the assistant shows the best next guesses. Recommendations come from the opening book
+ * (built on a background thread while the first guess is played), the transposition cache or the parallel recommender.
+ */
+
+#define TOP_K     5
+#define BUDGET_MS 80 // Leaves time for candidate generation, a recommendation is shown within 100ms
+#define CRITERION REC_WORST_CASE
+
+typedef struct
+{
+    bool is_complete; // All candidates were evaluated (opening book)
+    int num_scores;
+    RecScore scores[TOP_K];
+} CacheEntry;
+
+typedef struct
+{
+    MM_Context *ctx;
+    bool stop; // Protected by cache_mutex
+    pthread_t thread;
+} Book;
+
+// Transposition cache, kept for all assistant sessions
+static HashMap cache;
+static bool cache_initialized      = false;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool cache_get(const RecPosition *position, CacheEntry *out_entry)
+{
+    pthread_mutex_lock(&cache_mutex);
+    CacheEntry *entry = hm_get(&cache, position);
+    if (entry != NULL)
+    {
+        *out_entry = *entry;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    return entry != NULL;
+}
+
+static void cache_put(const RecPosition *position, const CacheEntry *entry)
+{
+    pthread_mutex_lock(&cache_mutex);
+    bool inserted;
+    CacheEntry *value = hm_put(&cache, position, &inserted);
+    // Don't replace complete results by ones that ran into the time limit
+    if (inserted || entry->is_complete || !value->is_complete)
+    {
+        *value = *entry;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+static void compute_entry(MM_Match *match, int budget_ms, CacheEntry *out_entry)
+{
+    out_entry->num_scores  = rec_get_top_k(match, CRITERION, budget_ms, NULL, TOP_K, out_entry->scores);
+    out_entry->is_complete = (budget_ms <= 0);
+}
+
+static bool is_stopped(Book *book)
+{
+    pthread_mutex_lock(&cache_mutex);
+    bool result = book->stop;
+    pthread_mutex_unlock(&cache_mutex);
+    return result;
+}
+
+// Evaluates the opening and each reply to its feedbacks without time limit
+static void *build_book(void *arg)
+{
+    Book *book = arg;
+    RecPosition position;
+    CacheEntry opening;
+
+    MM_Match *match = mm_new_match(book->ctx, true);
+    rec_get_position(match, &position);
+    if (!cache_get(&position, &opening) || !opening.is_complete)
+    {
+        compute_entry(match, 0, &opening);
+        cache_put(&position, &opening);
+    }
+    mm_free_match(match);
+
+    for (Feedback_t fb = 0; (opening.num_scores > 0) && (fb < mm_get_num_feedbacks(book->ctx)) && !is_stopped(book); fb++)
+    {
+        CacheEntry entry;
+        match = mm_new_match(book->ctx, true);
+        mm_constrain(match, opening.scores[0].guess, fb);
+        rec_get_position(match, &position);
+        if ((mm_get_remaining_solutions(match) > 0) && !mm_is_winning_feedback(book->ctx, fb)
+            && (!cache_get(&position, &entry) || !entry.is_complete))
+        {
+            compute_entry(match, 0, &entry);
+            cache_put(&position, &entry);
+        }
+        mm_free_match(match);
+    }
+    return NULL;
+}
+
+static void print_recommendations(MM_Context *ctx, const CacheEntry *entry)
+{
+    Table *tbl = tbl_get_new();
+    tbl_add_cells(tbl, 5, " # ", " Guess ", " Worst case ", " Expected ", " Consistent ");
+    tbl_next_row(tbl);
+    tbl_set_hline(tbl, TBL_BORDER_SINGLE);
+    for (int i = 0; i < entry->num_scores; i++)
+    {
+        tbl_add_cell_fmt(tbl, " %d ", i + 1);
+        tbl_add_cell_gc(tbl, get_colors_string(ctx, entry->scores[i].guess));
+        tbl_add_cell_fmt(tbl, " %" PRIu64 " ", (uint64_t)entry->scores[i].worst_case);
+        tbl_add_cell_fmt(tbl, " %.2f ", entry->scores[i].expected_size);
+        tbl_add_cell(tbl, entry->scores[i].is_consistent ? " * " : "");
+        tbl_next_row(tbl);
+    }
+    tbl_make_boxed(tbl, TBL_BORDER_SINGLE);
+    tbl_set_alternative_style(tbl);
+    tbl_print(tbl);
+    tbl_free(tbl);
+}
+
+// Shows recommendations for the current position, returns false if there are none
+static bool recommend(MM_Match *match, CacheEntry *out_entry)
+{
+    MM_Context *ctx = mm_get_context(match);
+    uint64_t start  = timer_now_us();
+
+    if (!mm_is_enumerable(ctx))
+    {
+        // Too many codes for partitions, only a single guess by evolutionary search
+        RecOptions options = { .criterion = CRITERION, .method = REC_METHOD_GENETIC };
+        RecResult result;
+        if (!rec_recommend(match, &options, &result))
+        {
+            return false;
+        }
+        *out_entry           = (CacheEntry){ .num_scores = 1 };
+        out_entry->scores[0] = (RecScore){ .guess = result.guess, .is_consistent = result.is_consistent };
+        printf("Recommended guess (%d ms):", (int)((timer_now_us() - start) / 1000));
+        print_colors(ctx, result.guess);
+        printf("\n");
+        return true;
+    }
+
+    RecPosition position;
+    rec_get_position(match, &position);
+    bool cached = cache_get(&position, out_entry);
+    if (!cached)
+    {
+        compute_entry(match, BUDGET_MS, out_entry);
+        cache_put(&position, out_entry);
+    }
+    if (out_entry->num_scores == 0)
+    {
+        return false;
+    }
+
+    printf("%" PRIu64 " solutions left, recommendations (%d ms%s):\n",
+           (uint64_t)mm_get_remaining_solutions(match),
+           (int)((timer_now_us() - start) / 1000),
+           cached ? (out_entry->is_complete ? ", from book" : ", from cache") : "");
+    print_recommendations(ctx, out_entry);
+    return true;
+}
+
+// Reads the guess that was played: Empty input or rank of a recommendation, or colors
+static bool read_played_guess(MM_Context *ctx, int turn, const CacheEntry *entry, Code_t *out_guess)
+{
+    while (true)
+    {
+        char *input = readline_fmt("Guess %d/%d played (empty for #1, rank or colors): ", turn, mm_get_max_guesses(ctx));
+        clear_input();
+        if (input == NULL)
+        {
+            return false;
+        }
+
+        char *end;
+        long rank    = strtol(input, &end, 10);
+        bool success = false;
+        if (input[0] == '\0')
+        {
+            *out_guess = entry->scores[0].guess;
+            success    = true;
+        }
+        else if ((*end == '\0') && (rank >= 1) && (rank <= entry->num_scores))
+        {
+            *out_guess = entry->scores[rank - 1].guess;
+            success    = true;
+        }
+        else
+        {
+            success = get_colors_from_string(ctx, input, out_guess);
+        }
+        free(input);
+        if (success)
+        {
+            return true;
+        }
+    }
+}
+
+static bool read_feedback(MM_Context *ctx, Feedback_t *out_feedback)
+{
+    int num_slots = mm_get_num_slots(ctx);
+    while (true)
+    {
+        int b, w;
+        if (!readline_int("Blacks", 0, 0, num_slots, &b) || !readline_int("Whites", 0, 0, num_slots - b, &w))
+        {
+            return false;
+        }
+        if ((b == num_slots - 1) && (w == 1))
+        {
+            printf("This feedback is not possible.\n");
+            continue;
+        }
+        *out_feedback = mm_feedback_to_code(ctx, b, w);
+        return true;
+    }
+}
+
+void assistant(MM_Context *ctx)
+{
+    if (!cache_initialized)
+    {
+        cache             = hm_create(sizeof(RecPosition), sizeof(CacheEntry));
+        cache_initialized = true;
+    }
+
+    // Without a thread, the assistant runs without opening book
+    Book book         = { .ctx = ctx, .stop = false };
+    bool book_started = mm_is_enumerable(ctx) && (pthread_create(&book.thread, NULL, build_book, &book) == 0);
+
+    MM_Match *match = mm_new_match(ctx, true);
+    while (mm_get_state(match) == MM_MATCH_PENDING)
+    {
+        CacheEntry entry;
+        Code_t guess;
+        Feedback_t feedback;
+        if (!recommend(match, &entry))
+        {
+            printf("No code is consistent with the feedbacks, please check them.\n");
+            break;
+        }
+        if (!read_played_guess(ctx, mm_get_turns(match) + 1, &entry, &guess) || !read_feedback(ctx, &feedback))
+        {
+            break;
+        }
+        mm_constrain(match, guess, feedback);
+        print_guess(-1, match, true);
+        printf("\n");
+    }
+
+    if (mm_get_state(match) == MM_MATCH_WON)
+    {
+        printf("Solved in %d turns.\n", mm_get_turns(match));
+    }
+    else if (mm_get_state(match) == MM_MATCH_LOST)
+    {
+        printf("Out of guesses.\n");
+    }
+    mm_free_match(match);
+
+    if (book_started)
+    {
+        pthread_mutex_lock(&cache_mutex);
+        book.stop = true;
+        pthread_mutex_unlock(&cache_mutex);
+        pthread_join(book.thread, NULL);
+    }
+}
@@ -0,0 +1,4 @@
+#pragma once
+#include "mastermind.h"
+
+void assistant(MM_Context *ctx);
@@ -0,0 +1,398 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "consistent.h"
+#include "mastermind.h"
+#include "util/hash_map.h"
+
+/*
+ * Finds and counts codes consistent with the history of a match without enumerating the code space.
+ * Finding: Backtracking over slots with per-slot color domains, forward checking of black counts
+ *     (per slot) and of total matches (black + white, per color count) after each assignment.
+ * Counting: Dynamic programming over slots, the state being the black count per guess and the
+ *     multiplicity of each guessed color, capped where more occurrences can't change any feedback.
+ *     Colors that were never guessed are interchangeable and handled as a multiplier.
+ * Finding supports the rule variants, counting only classic rules: Variant contexts are always enumerated.
+ */
+
+typedef uint32_t Domain_t;
+
+typedef struct
+{
+    int num_slots;
+    int num_colors;
+    int num_guesses;
+    Rng *rng;          // NULL: Colors are tried in ascending order
+    bool no_repeat;    // MM_RULES_NO_REPEAT: Assigned color is removed from other domains
+    bool count_whites; // False for MM_RULES_BLACK_ONLY, target_matches are unknown
+    int guess_colors[MM_MAX_MAX_GUESSES][MM_MAX_NUM_SLOTS];
+    int guess_counts[MM_MAX_MAX_GUESSES][MM_MAX_NUM_COLORS];
+    int target_blacks[MM_MAX_MAX_GUESSES];
+    int target_matches[MM_MAX_MAX_GUESSES]; // Blacks + whites
+
+    // Search state
+    int colors[MM_MAX_NUM_SLOTS]; // -1 if unassigned
+    int counts[MM_MAX_NUM_COLORS];
+    int blacks[MM_MAX_MAX_GUESSES];
+    int matches[MM_MAX_MAX_GUESSES];
+} Search;
+
+static int popcount(Domain_t x)
+{
+    int result = 0;
+    while (x != 0)
+    {
+        x &= x - 1;
+        result++;
+    }
+    return result;
+}
+
+/*
+ * Summary: Removes colors from domains of unassigned slots that would violate a constraint
+ * Returns: False if a constraint can't be satisfied anymore
+ */
+static bool propagate(Search *s, Domain_t *domains)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed            = false;
+        int num_unassigned = 0;
+        for (int i = 0; i < s->num_slots; i++)
+        {
+            if (s->colors[i] == -1)
+            {
+                num_unassigned++;
+            }
+        }
+
+        for (int j = 0; j < s->num_guesses; j++)
+        {
+            int possible_blacks = 0;
+            for (int i = 0; i < s->num_slots; i++)
+            {
+                if ((s->colors[i] == -1) && (domains[i] & (1u << s->guess_colors[j][i])))
+                {
+                    possible_blacks++;
+                }
+            }
+
+            if ((s->blacks[j] > s->target_blacks[j])
+                || (s->blacks[j] + possible_blacks < s->target_blacks[j])
+                || (s->count_whites && (s->matches[j] > s->target_matches[j]))
+                || (s->count_whites && (s->matches[j] + num_unassigned < s->target_matches[j])))
+            {
+                return false;
+            }
+
+            // Colors that would still increase matches with guess j
+            Domain_t increasing = 0;
+            for (int c = 0; c < s->num_colors; c++)
+            {
+                if (s->counts[c] < s->guess_counts[j][c])
+                {
+                    increasing |= 1u << c;
+                }
+            }
+
+            for (int i = 0; i < s->num_slots; i++)
+            {
+                if (s->colors[i] != -1)
+                {
+                    continue;
+                }
+                Domain_t before = domains[i];
+                Domain_t black  = 1u << s->guess_colors[j][i];
+                if (s->blacks[j] == s->target_blacks[j])
+                {
+                    domains[i] &= ~black;
+                }
+                else if ((s->blacks[j] + possible_blacks == s->target_blacks[j]) && (domains[i] & black))
+                {
+                    domains[i] = black;
+                }
+                if (s->count_whites && (s->matches[j] == s->target_matches[j]))
+                {
+                    domains[i] &= ~increasing;
+                }
+                else if (s->count_whites && (s->matches[j] + num_unassigned == s->target_matches[j]))
+                {
+                    domains[i] &= increasing;
+                }
+
+                if (domains[i] == 0)
+                {
+                    return false;
+                }
+                if (domains[i] != before)
+                {
+                    changed = true;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void assign(Search *s, int slot, int color, int delta)
+{
+    if (delta < 0)
+    {
+        s->counts[color]--;
+    }
+    for (int j = 0; j < s->num_guesses; j++)
+    {
+        if (s->guess_colors[j][slot] == color)
+        {
+            s->blacks[j] += delta;
+        }
+        if (s->counts[color] < s->guess_counts[j][color])
+        {
+            s->matches[j] += delta;
+        }
+    }
+    if (delta > 0)
+    {
+        s->counts[color]++;
+        s->colors[slot] = color;
+    }
+    else
+    {
+        s->colors[slot] = -1;
+    }
+}
+
+static bool search(Search *s, const Domain_t *domains, int depth)
+{
+    if (depth == s->num_slots)
+    {
+        return true;
+    }
+
+    // Most constrained slot first
+    int slot = -1;
+    for (int i = 0; i < s->num_slots; i++)
+    {
+        if ((s->colors[i] == -1) && ((slot == -1) || (popcount(domains[i]) < popcount(domains[slot]))))
+        {
+            slot = i;
+        }
+    }
+
+    int order[MM_MAX_NUM_COLORS];
+    int num_values = 0;
+    for (int c = 0; c < s->num_colors; c++)
+    {
+        if (domains[slot] & (1u << c))
+        {
+            order[num_values++] = c;
+        }
+    }
+    if (s->rng != NULL)
+    {
+        for (int i = num_values - 1; i > 0; i--)
+        {
+            int j    = rng_below(s->rng, i + 1);
+            int temp = order[i];
+            order[i] = order[j];
+            order[j] = temp;
+        }
+    }
+
+    for (int v = 0; v < num_values; v++)
+    {
+        Domain_t next[MM_MAX_NUM_SLOTS];
+        for (int i = 0; i < s->num_slots; i++)
+        {
+            next[i] = s->no_repeat ? (domains[i] & ~(1u << order[v])) : domains[i];
+        }
+        next[slot] = 1u << order[v];
+
+        assign(s, slot, order[v], 1);
+        if (propagate(s, next) && search(s, next, depth + 1))
+        {
+            return true;
+        }
+        assign(s, slot, order[v], -1);
+    }
+    return false;
+}
+
+/*
+ * Summary: Searches for a code that is consistent with all guesses and feedbacks of match
+ * Params:
+ *     randomize: Whether colors are tried in random order instead of ascending,
+ *         so that a random consistent code is found instead of the lowest one
+ * Returns: False if no consistent code exists
+ */
+bool csp_find_consistent(MM_Match *match, bool randomize, Code_t *out_code)
+{
+    MM_Context *ctx = mm_get_context(match);
+    Search s        = { .num_slots    = mm_get_num_slots(ctx),
+                        .num_colors   = mm_get_num_colors(ctx),
+                        .num_guesses  = mm_get_turns(match),
+                        .rng          = randomize ? mm_get_match_rng(match) : NULL,
+                        .no_repeat    = (mm_get_rules(ctx) & MM_RULES_NO_REPEAT) != 0,
+                        .count_whites = !(mm_get_rules(ctx) & MM_RULES_BLACK_ONLY) };
+
+    for (int j = 0; j < s.num_guesses; j++)
+    {
+        int b, w;
+        mm_code_to_feedback(ctx, mm_get_history_feedback(match, j), &b, &w);
+        mm_code_to_colors(ctx, mm_get_history_guess(match, j), s.guess_colors[j]);
+        for (int i = 0; i < s.num_slots; i++)
+        {
+            s.guess_counts[j][s.guess_colors[j][i]]++;
+        }
+        s.target_blacks[j]  = b;
+        s.target_matches[j] = b + w;
+    }
+
+    Domain_t domains[MM_MAX_NUM_SLOTS];
+    for (int i = 0; i < s.num_slots; i++)
+    {
+        s.colors[i] = -1;
+        domains[i]  = (1u << s.num_colors) - 1;
+    }
+
+    if (!propagate(&s, domains) || !search(&s, domains, 0))
+    {
+        return false;
+    }
+    *out_code = mm_colors_to_code(ctx, s.colors);
+    return true;
+}
+
+typedef struct
+{
+    int num_slots;
+    int num_guesses;
+    int num_free_colors;
+    int num_used_colors;
+    int used_colors[MM_MAX_NUM_COLORS];
+    int caps[MM_MAX_NUM_COLORS];
+    int guess_colors[MM_MAX_MAX_GUESSES][MM_MAX_NUM_SLOTS];
+    int guess_counts[MM_MAX_MAX_GUESSES][MM_MAX_NUM_COLORS];
+    int target_blacks[MM_MAX_MAX_GUESSES];
+    int target_matches[MM_MAX_MAX_GUESSES];
+    HashMap memo;
+} Counter;
+
+// Key layout: [slot][blacks per guess][count per used color]
+#define KEY_SIZE (1 + MM_MAX_MAX_GUESSES + MM_MAX_NUM_COLORS)
+
+static uint64_t count(Counter *cnt, uint8_t *key)
+{
+    int slot        = key[0];
+    uint8_t *blacks = key + 1;
+    uint8_t *counts = key + 1 + cnt->num_guesses;
+    int remaining   = cnt->num_slots - slot;
+
+    for (int j = 0; j < cnt->num_guesses; j++)
+    {
+        int matches = 0;
+        for (int c = 0; c < cnt->num_used_colors; c++)
+        {
+            int col = cnt->used_colors[c];
+            matches += (counts[c] < cnt->guess_counts[j][col]) ? counts[c] : cnt->guess_counts[j][col];
+        }
+        if ((blacks[j] > cnt->target_blacks[j])
+            || (blacks[j] + remaining < cnt->target_blacks[j])
+            || (matches > cnt->target_matches[j])
+            || (matches + remaining < cnt->target_matches[j]))
+        {
+            return 0;
+        }
+    }
+    if (remaining == 0)
+    {
+        return 1;
+    }
+
+    uint64_t *memo = hm_get(&cnt->memo, key);
+    if (memo != NULL)
+    {
+        return *memo;
+    }
+
+    uint8_t next[KEY_SIZE] = { 0 };
+    memcpy(next, key, KEY_SIZE);
+    next[0]++;
+
+    // Any color that was never guessed
+    uint64_t result = cnt->num_free_colors * count(cnt, next);
+
+    for (int c = 0; c < cnt->num_used_colors; c++)
+    {
+        int col = cnt->used_colors[c];
+        memcpy(next, key, KEY_SIZE);
+        next[0]++;
+        for (int j = 0; j < cnt->num_guesses; j++)
+        {
+            if (cnt->guess_colors[j][slot] == col)
+            {
+                next[1 + j]++;
+            }
+        }
+        if (next[1 + cnt->num_guesses + c] < cnt->caps[c])
+        {
+            next[1 + cnt->num_guesses + c]++;
+        }
+        result += count(cnt, next);
+    }
+
+    *(uint64_t *)hm_put(&cnt->memo, key, NULL) = result;
+    return result;
+}
+
+/*
+ * Summary: Counts codes that are consistent with all guesses and feedbacks of match
+ */
+uint64_t csp_count_consistent(MM_Match *match)
+{
+    MM_Context *ctx = mm_get_context(match);
+    Counter cnt     = { .num_slots   = mm_get_num_slots(ctx),
+                        .num_guesses = mm_get_turns(match),
+                        .memo        = hm_create(KEY_SIZE, sizeof(uint64_t)) };
+
+    int caps[MM_MAX_NUM_COLORS] = { 0 };
+    for (int j = 0; j < cnt.num_guesses; j++)
+    {
+        int b, w;
+        mm_code_to_feedback(ctx, mm_get_history_feedback(match, j), &b, &w);
+        mm_code_to_colors(ctx, mm_get_history_guess(match, j), cnt.guess_colors[j]);
+        for (int i = 0; i < cnt.num_slots; i++)
+        {
+            cnt.guess_counts[j][cnt.guess_colors[j][i]]++;
+        }
+        for (int c = 0; c < mm_get_num_colors(ctx); c++)
+        {
+            if (cnt.guess_counts[j][c] > caps[c])
+            {
+                caps[c] = cnt.guess_counts[j][c];
+            }
+        }
+        cnt.target_blacks[j]  = b;
+        cnt.target_matches[j] = b + w;
+    }
+
+    for (int c = 0; c < mm_get_num_colors(ctx); c++)
+    {
+        if (caps[c] == 0)
+        {
+            cnt.num_free_colors++;
+        }
+        else
+        {
+            cnt.used_colors[cnt.num_used_colors] = c;
+            cnt.caps[cnt.num_used_colors]        = caps[c];
+            cnt.num_used_colors++;
+        }
+    }
+
+    uint8_t key[KEY_SIZE] = { 0 };
+    uint64_t result       = count(&cnt, key);
+    hm_destroy(&cnt.memo);
+    return result;
+}
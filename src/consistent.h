@@ -0,0 +1,6 @@
+#pragma once
+#include <stdbool.h>
+#include "mastermind.h"
+
+bool csp_find_consistent(MM_Match *match, bool randomize, Code_t *out_code);
+uint64_t csp_count_consistent(MM_Match *match);
@@ -0,0 +1,80 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "evil.h"
+#include "mastermind.h"
+#include "util/console.h"
+
+/*
+ * Adaptive adversary: The secret is never fixed. Each guess is answered with the feedback that keeps
+ * the most solutions alive, so the player has to corner the codemaker. The partition comes from one pass
+ * over the solution space of the match.
+ */
+
+// Feedback of the largest part, ties are broken by fewer blacks. Winning only if nothing else is left
+static Feedback_t choose_feedback(MM_Context *ctx, const CodeSize_t *counts)
+{
+    Feedback_t result = 0;
+    int result_b      = 0;
+    bool found        = false;
+    for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+    {
+        int b, w;
+        mm_code_to_feedback(ctx, fb, &b, &w);
+        if ((counts[fb] == 0) || (found && mm_is_winning_feedback(ctx, fb)))
+        {
+            continue;
+        }
+        if (!found || mm_is_winning_feedback(ctx, result) || (counts[fb] > counts[result])
+            || ((counts[fb] == counts[result]) && (b < result_b)))
+        {
+            result   = fb;
+            result_b = b;
+            found    = true;
+        }
+    }
+    return result;
+}
+
+// Any remaining solution, the codemaker commits to it when the player runs out of guesses
+static Code_t get_random_solution(MM_Match *match)
+{
+    Code_t *solutions   = malloc(mm_get_remaining_solutions(match) * sizeof(Code_t));
+    CodeSize_t num_sols = mm_get_solutions(match, solutions);
+    Code_t result       = solutions[rng_below(mm_get_match_rng(match), num_sols)];
+    free(solutions);
+    return result;
+}
+
+void evil(MM_Context *ctx)
+{
+    if (!mm_is_enumerable(ctx))
+    {
+        printf("Too many codes for the evil codemaker, choose fewer slots or colors.\n");
+        return;
+    }
+
+    MM_Match *match = mm_new_match(ctx, true);
+    while (mm_get_state(match) == MM_MATCH_PENDING)
+    {
+        Code_t input;
+        if (!read_colors(ctx, mm_get_turns(match) + 1, &input))
+        {
+            printf("Aborted. %" PRIu64 " solutions were still possible.\n", (uint64_t)mm_get_remaining_solutions(match));
+            mm_free_match(match);
+            return;
+        }
+
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        mm_get_solution_partition(match, input, counts);
+        mm_constrain(match, input, choose_feedback(ctx, counts));
+        print_guess(mm_get_turns(match) - 1, match, true);
+        printf("\n");
+    }
+
+    Code_t solution = (mm_get_state(match) == MM_MATCH_WON) ? mm_get_history_guess(match, mm_get_turns(match) - 1)
+                                                             : get_random_solution(match);
+    print_match_end_message(match, solution, true);
+    mm_free_match(match);
+}
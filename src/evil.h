@@ -0,0 +1,4 @@
+#pragma once
+#include "mastermind.h"
+
+void evil(MM_Context *ctx);
@@ -0,0 +1,223 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "feedback_table.h"
+
+#define MIN(a, b) (a < b ? a : b)
+
+#define MAX_N (MM_MAX_NUM_SLOTS + 1)
+
+// Pascal's triangle up to num_slots
+static void get_binomials(int num_slots, uint64_t binomials[MAX_N][MAX_N])
+{
+    memset(binomials, 0, MAX_N * MAX_N * sizeof(uint64_t));
+    for (int n = 0; n <= num_slots; n++)
+    {
+        binomials[n][0] = 1;
+        for (int k = 1; k <= n; k++)
+        {
+            binomials[n][k] = binomials[n - 1][k - 1] + binomials[n - 1][k];
+        }
+    }
+}
+
+/*
+ * Summary: Counts codes by blacks and matches (blacks + whites) against a guess with the given color multiplicities.
+ *     First the codes with j marked slots that agree with the guess (the other slots are arbitrary) are counted:
+ *     Per color c, j_c marks are chosen in its slots and r_c more slots out of the n - j unmarked ones,
+ *     the code holds j_c + r_c of c and matches min(a_c, j_c + r_c). Unmarked slots left take any unused color.
+ *     Inclusion-exclusion over the marks gives the codes with exactly b blacks. Arithmetic is modulo 2^64,
+ *     exact because every result is at most the number of codes.
+ */
+static void count_by_matches(int num_slots, int num_colors, const int *mults, int num_used, uint64_t out_counts[MAX_N][MAX_N])
+{
+    uint64_t binomials[MAX_N][MAX_N];
+    uint64_t marked[MAX_N][MAX_N] = { { 0 } }; // [marks][matches]
+    uint64_t states[2][MAX_N][MAX_N][MAX_N];   // [marks][unmarked slots used][matches]
+    get_binomials(num_slots, binomials);
+
+    for (int j = 0; j <= num_slots; j++)
+    {
+        int pool = num_slots - j;
+        memset(states[0], 0, sizeof(states[0]));
+        states[0][0][0][0] = 1;
+        for (int c = 0; c < num_used; c++)
+        {
+            uint64_t(*cur)[MAX_N][MAX_N]  = states[c & 1];
+            uint64_t(*next)[MAX_N][MAX_N] = states[(c + 1) & 1];
+            memset(next, 0, sizeof(states[0]));
+            for (int jm = 0; jm <= j; jm++)
+            {
+                for (int pu = 0; pu <= pool; pu++)
+                {
+                    for (int t = 0; t <= num_slots; t++)
+                    {
+                        uint64_t value = cur[jm][pu][t];
+                        if (value == 0)
+                        {
+                            continue;
+                        }
+                        for (int jc = 0; jc <= MIN(mults[c], j - jm); jc++)
+                        {
+                            for (int rc = 0; rc <= pool - pu; rc++)
+                            {
+                                next[jm + jc][pu + rc][t + MIN(mults[c], jc + rc)]
+                                    += value * binomials[mults[c]][jc] * binomials[pool - pu][rc];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        uint64_t(*last)[MAX_N][MAX_N] = states[num_used & 1];
+        for (int pu = 0; pu <= pool; pu++)
+        {
+            uint64_t free_codes = 1;
+            for (int i = pu; i < pool; i++)
+            {
+                free_codes *= num_colors - num_used;
+            }
+            for (int t = 0; t <= num_slots; t++)
+            {
+                marked[j][t] += last[j][pu][t] * free_codes;
+            }
+        }
+    }
+
+    for (int b = 0; b <= num_slots; b++)
+    {
+        for (int t = 0; t <= num_slots; t++)
+        {
+            uint64_t sum = 0;
+            for (int j = b; j <= num_slots; j++)
+            {
+                uint64_t term = binomials[j][b] * marked[j][t];
+                sum           = ((j - b) % 2 == 0) ? sum + term : sum - term;
+            }
+            out_counts[b][t] = sum;
+        }
+    }
+}
+
+// Partition of all codes by their feedback against a guess with the given color multiplicities
+static void get_partition(MM_Context *ctx, const int *mults, int num_used, CodeSize_t *out_counts)
+{
+    int num_slots = mm_get_num_slots(ctx);
+    uint64_t counts[MAX_N][MAX_N];
+    count_by_matches(num_slots, mm_get_num_colors(ctx), mults, num_used, counts);
+
+    memset(out_counts, 0, mm_get_num_feedbacks(ctx) * sizeof(CodeSize_t));
+    for (int b = 0; b <= num_slots; b++)
+    {
+        for (int t = b; t <= num_slots; t++)
+        {
+            if (counts[b][t] != 0)
+            {
+                out_counts[mm_feedback_to_code(ctx, b, t - b)] += counts[b][t];
+            }
+        }
+    }
+}
+
+/*
+ * Summary: Partition of the whole code space by feedback against guess, same as mm_get_partition_range over all codes
+ * Returns: false for MM_RULES_NO_REPEAT
+ */
+bool ft_get_partition(MM_Context *ctx, Code_t guess, CodeSize_t *out_counts)
+{
+    if (mm_get_rules(ctx) & MM_RULES_NO_REPEAT)
+    {
+        return false;
+    }
+    int colors[MM_MAX_NUM_SLOTS];
+    int color_counts[MM_MAX_NUM_COLORS] = { 0 };
+    int mults[MM_MAX_NUM_SLOTS];
+    int num_used = 0;
+    mm_code_to_colors(ctx, guess, colors);
+    for (int i = 0; i < mm_get_num_slots(ctx); i++)
+    {
+        color_counts[colors[i]]++;
+    }
+    for (int c = 0; c < mm_get_num_colors(ctx); c++)
+    {
+        if (color_counts[c] != 0)
+        {
+            mults[num_used++] = color_counts[c];
+        }
+    }
+    get_partition(ctx, mults, num_used, out_counts);
+    return true;
+}
+
+// Number of codes whose color multiplicities are mults (non-increasing): Choice of colors times arrangements
+static uint64_t count_codes(int num_slots, int num_colors, const int *mults, int num_used)
+{
+    uint64_t result = 1;
+    for (int i = 0; i < num_used; i++)
+    {
+        result *= num_colors - i;
+    }
+    int run = 0;
+    for (int i = 0; i < num_used; i++)
+    {
+        run     = ((i > 0) && (mults[i] == mults[i - 1])) ? run + 1 : 1;
+        result /= run; // Colors of equal multiplicity are interchangeable
+    }
+
+    int remaining = num_slots;
+    for (int i = 0; i < num_used; i++)
+    {
+        uint64_t binomial = 1;
+        for (int k = 0; k < mults[i]; k++)
+        {
+            binomial = binomial * (remaining - k) / (k + 1);
+        }
+        result    *= binomial;
+        remaining -= mults[i];
+    }
+    return result;
+}
+
+// Adds statistics of all guesses whose multiplicities start with mults, remaining slots are split in parts of at most max_part
+static void add_partitions(MM_Context *ctx, int *mults, int num_used, int remaining, int max_part, MM_FeedbackStats *stats)
+{
+    if (remaining == 0)
+    {
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        uint64_t num_codes = count_codes(mm_get_num_slots(ctx), mm_get_num_colors(ctx), mults, num_used);
+        get_partition(ctx, mults, num_used, counts);
+        for (int fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+        {
+            stats->num_pairs[fb] += num_codes * counts[fb];
+            stats->num_hits[fb]  += (counts[fb] != 0) ? num_codes : 0;
+        }
+        return;
+    }
+    if (num_used == mm_get_num_colors(ctx))
+    {
+        return;
+    }
+    for (int part = MIN(remaining, max_part); part >= 1; part--)
+    {
+        mults[num_used] = part;
+        add_partitions(ctx, mults, num_used + 1, remaining - part, part, stats);
+    }
+}
+
+/*
+ * Summary: Feedback statistics over all pairs of codes (see mm_get_feedback_stats), summed over the multiplicity
+ *     patterns of the guess weighted by their number of codes
+ * Returns: false for MM_RULES_NO_REPEAT or if pair counts could exceed 64 bits
+ */
+bool ft_get_stats(MM_Context *ctx, MM_FeedbackStats *out_stats)
+{
+    if ((mm_get_rules(ctx) & MM_RULES_NO_REPEAT) || (mm_get_num_codes(ctx) > UINT32_MAX))
+    {
+        return false;
+    }
+    int mults[MM_MAX_NUM_SLOTS];
+    memset(out_stats, 0, sizeof(MM_FeedbackStats));
+    add_partitions(ctx, mults, 0, mm_get_num_slots(ctx), mm_get_num_slots(ctx), out_stats);
+    return true;
+}
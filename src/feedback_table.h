@@ -0,0 +1,13 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "mastermind.h"
+
+/*
+ * Feedback distributions in closed form by multinomial counting, no code is enumerated:
+ * Against a guess, only its color multiplicities matter, so the statistics over all pairs
+ * follow from the integer partitions of num_slots. Not for MM_RULES_NO_REPEAT.
+ */
+
+bool ft_get_partition(MM_Context *ctx, Code_t guess, CodeSize_t *out_counts);
+bool ft_get_stats(MM_Context *ctx, MM_FeedbackStats *out_stats);
@@ -0,0 +1,395 @@
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "genetic.h"
+#include "mastermind.h"
+#include "recommend.h"
+#include "util/timer.h"
+
+/*
+ * Evolutionary codebreaker that doesn't enumerate the code space (after Berghman et al.):
+ * Each island evolves a population towards codes that are consistent with the history,
+ * fitness being the total deviation of black and white counts. Consistent codes are collected
+ * and the guess is chosen among them by using them as a sample of the remaining solutions.
+ */
+
+#define MIGRATION_INTERVAL 10
+#define TOURNAMENT_SIZE    3
+#define MUTATION_RATE      3 // Percent
+#define PERMUTATION_RATE   3
+#define INVERSION_RATE     2
+
+typedef struct
+{
+    MM_Context *ctx;
+    const GaOptions *options;
+    int num_slots;
+    int num_colors;
+    int num_guesses;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    int blacks[MM_MAX_MAX_GUESSES];
+    int whites[MM_MAX_MAX_GUESSES];
+
+    Rng rng; // Seeded from the match, islands draw independently
+    Code_t *population;
+    Code_t *offspring;
+    int *fitness;
+    Feedback_t *feedbacks; // Scratch buffer for batched fitness evaluation
+    Code_t *eligible;
+    int num_eligible;
+    int num_generations;
+} Island;
+
+static int random_int(Island *island, int max)
+{
+    return rng_below(&island->rng, max);
+}
+
+// Replaces repeated colors by random unused ones if the rules forbid repetition
+static void repair(Island *island, int *colors)
+{
+    if (!(mm_get_rules(island->ctx) & MM_RULES_NO_REPEAT))
+    {
+        return;
+    }
+    uint32_t used = 0;
+    for (int i = 0; i < island->num_slots; i++)
+    {
+        while (used & (1u << colors[i]))
+        {
+            colors[i] = random_int(island, island->num_colors);
+        }
+        used |= 1u << colors[i];
+    }
+}
+
+static Code_t random_code(Island *island)
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    for (int i = 0; i < island->num_slots; i++)
+    {
+        colors[i] = random_int(island, island->num_colors);
+    }
+    repair(island, colors);
+    return mm_colors_to_code(island->ctx, colors);
+}
+
+static void add_eligible(Island *island, Code_t code)
+{
+    if (island->num_eligible == island->options->max_eligible)
+    {
+        return;
+    }
+    for (int i = 0; i < island->num_eligible; i++)
+    {
+        if (island->eligible[i] == code)
+        {
+            return;
+        }
+    }
+    island->eligible[island->num_eligible++] = code;
+}
+
+// Fitness is evaluated guess by guess for the whole population at once
+static void evaluate_population(Island *island)
+{
+    int size = island->options->population_size;
+    for (int i = 0; i < size; i++)
+    {
+        island->fitness[i] = 0;
+    }
+    for (int j = 0; j < island->num_guesses; j++)
+    {
+        mm_get_feedbacks(island->ctx, island->guesses[j], island->population, size, island->feedbacks);
+        for (int i = 0; i < size; i++)
+        {
+            int b, w;
+            mm_code_to_feedback(island->ctx, island->feedbacks[i], &b, &w);
+            island->fitness[i] += abs(b - island->blacks[j]) + abs(w - island->whites[j]);
+        }
+    }
+    for (int i = 0; i < size; i++)
+    {
+        if (island->fitness[i] == 0)
+        {
+            add_eligible(island, island->population[i]);
+        }
+    }
+}
+
+static int get_best_index(const Island *island)
+{
+    int result = 0;
+    for (int i = 1; i < island->options->population_size; i++)
+    {
+        if (island->fitness[i] < island->fitness[result])
+        {
+            result = i;
+        }
+    }
+    return result;
+}
+
+static int get_worst_index(const Island *island)
+{
+    int result = 0;
+    for (int i = 1; i < island->options->population_size; i++)
+    {
+        if (island->fitness[i] > island->fitness[result])
+        {
+            result = i;
+        }
+    }
+    return result;
+}
+
+static Code_t select_parent(Island *island)
+{
+    int result = random_int(island, island->options->population_size);
+    for (int i = 1; i < TOURNAMENT_SIZE; i++)
+    {
+        int other = random_int(island, island->options->population_size);
+        if (island->fitness[other] < island->fitness[result])
+        {
+            result = other;
+        }
+    }
+    return island->population[result];
+}
+
+static Code_t breed(Island *island)
+{
+    int a[MM_MAX_NUM_SLOTS];
+    int b[MM_MAX_NUM_SLOTS];
+    int n = island->num_slots;
+    mm_code_to_colors(island->ctx, select_parent(island), a);
+    mm_code_to_colors(island->ctx, select_parent(island), b);
+
+    // One- or two-point crossover
+    int from = random_int(island, n);
+    int to   = (random_int(island, 2) == 0) ? n : from + random_int(island, n - from) + 1;
+    for (int i = from; i < to; i++)
+    {
+        a[i] = b[i];
+    }
+
+    if (random_int(island, 100) < MUTATION_RATE)
+    {
+        a[random_int(island, n)] = random_int(island, island->num_colors);
+    }
+    if (random_int(island, 100) < PERMUTATION_RATE)
+    {
+        int i    = random_int(island, n);
+        int j    = random_int(island, n);
+        int temp = a[i];
+        a[i]     = a[j];
+        a[j]     = temp;
+    }
+    if (random_int(island, 100) < INVERSION_RATE)
+    {
+        int i = random_int(island, n);
+        int j = random_int(island, n);
+        for (; i < j; i++, j--)
+        {
+            int temp = a[i];
+            a[i]     = a[j];
+            a[j]     = temp;
+        }
+    }
+    repair(island, a);
+    return mm_colors_to_code(island->ctx, a);
+}
+
+static void *run_island(void *arg)
+{
+    Island *island = arg;
+    int size       = island->options->population_size;
+    for (int gen = 0; gen < MIGRATION_INTERVAL; gen++)
+    {
+        if ((island->num_eligible == island->options->max_eligible) || timer_expired(island->options->deadline_us))
+        {
+            break;
+        }
+
+        island->offspring[0] = island->population[get_best_index(island)]; // Elitism
+        for (int i = 1; i < size; i++)
+        {
+            island->offspring[i] = breed(island);
+        }
+
+        Code_t *temp       = island->population;
+        island->population = island->offspring;
+        island->offspring  = temp;
+        evaluate_population(island);
+        island->num_generations++;
+    }
+    return NULL;
+}
+
+// Chooses the eligible code that partitions the other eligible codes best
+static Code_t choose_among_eligible(MM_Context *ctx, RecCriterion criterion, const Code_t *eligible, int num_eligible)
+{
+    Code_t result = eligible[0];
+    double best   = 0;
+    for (int i = 0; i < num_eligible; i++)
+    {
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        mm_get_partition(ctx, eligible[i], eligible, num_eligible, counts);
+        double score = rec_score_partition(criterion, num_eligible, mm_get_num_feedbacks(ctx), counts);
+        if ((i == 0) || (score < best))
+        {
+            result = eligible[i];
+            best   = score;
+        }
+    }
+    return result;
+}
+
+GaOptions ga_get_default_options()
+{
+    return (GaOptions){
+        .criterion       = REC_MOST_PARTS,
+        .num_islands     = 4,
+        .population_size = 150,
+        .max_generations = 100,
+        .max_eligible    = 60,
+        .deadline_us     = timer_deadline_us(0)
+    };
+}
+
+/*
+ * Summary: Evolves islands in parallel, migrating the best code of each island
+ *     to the next one every MIGRATION_INTERVAL generations
+ * Returns: True if out_guess is consistent with the history of match
+ */
+bool ga_find_guess(MM_Match *match, const GaOptions *options, Code_t *out_guess)
+{
+    MM_Context *ctx    = mm_get_context(match);
+    int size           = options->population_size;
+    Island *islands    = malloc(options->num_islands * sizeof(Island));
+    pthread_t *threads = malloc(options->num_islands * sizeof(pthread_t));
+    bool *started      = malloc(options->num_islands * sizeof(bool));
+
+    for (int k = 0; k < options->num_islands; k++)
+    {
+        Island *island = &islands[k];
+        *island        = (Island){ .ctx         = ctx,
+                                   .options     = options,
+                                   .num_slots   = mm_get_num_slots(ctx),
+                                   .num_colors  = mm_get_num_colors(ctx),
+                                   .num_guesses = mm_get_turns(match),
+                                   .population  = malloc(size * sizeof(Code_t)),
+                                   .offspring   = malloc(size * sizeof(Code_t)),
+                                   .fitness     = malloc(size * sizeof(int)),
+                                   .feedbacks   = malloc(size * sizeof(Feedback_t)),
+                                   .eligible    = malloc(options->max_eligible * sizeof(Code_t)) };
+        rng_seed(&island->rng, rng_next(mm_get_match_rng(match)));
+        for (int j = 0; j < island->num_guesses; j++)
+        {
+            island->guesses[j] = mm_get_history_guess(match, j);
+            mm_code_to_feedback(ctx, mm_get_history_feedback(match, j), &island->blacks[j], &island->whites[j]);
+        }
+        for (int i = 0; i < size; i++)
+        {
+            island->population[i] = random_code(island);
+        }
+        evaluate_population(island);
+    }
+
+    for (int gen = 0; (gen < options->max_generations) && !timer_expired(options->deadline_us); gen += MIGRATION_INTERVAL)
+    {
+        for (int k = 0; k < options->num_islands; k++)
+        {
+            // Out of threads: The island evolves on this one
+            started[k] = (pthread_create(&threads[k], NULL, run_island, &islands[k]) == 0);
+            if (!started[k])
+            {
+                run_island(&islands[k]);
+            }
+        }
+        int num_eligible = 0;
+        for (int k = 0; k < options->num_islands; k++)
+        {
+            if (started[k])
+            {
+                pthread_join(threads[k], NULL);
+            }
+            num_eligible += islands[k].num_eligible;
+        }
+        if ((num_eligible >= options->max_eligible) || timer_expired(options->deadline_us))
+        {
+            break;
+        }
+
+        // Ring migration, fitness stays valid since all islands share the history
+        Island *last        = &islands[options->num_islands - 1];
+        Code_t migrant      = last->population[get_best_index(last)];
+        int migrant_fitness = last->fitness[get_best_index(last)];
+        for (int k = 0; k < options->num_islands; k++)
+        {
+            Island *island   = &islands[k];
+            int best         = get_best_index(island);
+            int worst        = get_worst_index(island);
+            Code_t next      = island->population[best];
+            int next_fitness = island->fitness[best];
+
+            island->population[worst] = migrant;
+            island->fitness[worst]    = migrant_fitness;
+            migrant                   = next;
+            migrant_fitness           = next_fitness;
+        }
+    }
+
+    // Merge eligible codes of all islands
+    Code_t *eligible = malloc(options->num_islands * options->max_eligible * sizeof(Code_t));
+    int num_eligible = 0;
+    int best_island  = 0;
+    for (int k = 0; k < options->num_islands; k++)
+    {
+        for (int i = 0; i < islands[k].num_eligible; i++)
+        {
+            bool duplicate = false;
+            for (int j = 0; j < num_eligible; j++)
+            {
+                if (eligible[j] == islands[k].eligible[i])
+                {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate)
+            {
+                eligible[num_eligible++] = islands[k].eligible[i];
+            }
+        }
+        if (islands[k].fitness[get_best_index(&islands[k])] < islands[best_island].fitness[get_best_index(&islands[best_island])])
+        {
+            best_island = k;
+        }
+    }
+
+    bool result = (num_eligible != 0);
+    if (result)
+    {
+        *out_guess = choose_among_eligible(ctx, options->criterion, eligible, num_eligible);
+    }
+    else
+    {
+        *out_guess = islands[best_island].population[get_best_index(&islands[best_island])];
+    }
+
+    for (int k = 0; k < options->num_islands; k++)
+    {
+        free(islands[k].population);
+        free(islands[k].offspring);
+        free(islands[k].fitness);
+        free(islands[k].feedbacks);
+        free(islands[k].eligible);
+    }
+    free(eligible);
+    free(islands);
+    free(threads);
+    free(started);
+    return result;
+}
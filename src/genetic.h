@@ -0,0 +1,18 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "mastermind.h"
+#include "recommend.h"
+
+typedef struct
+{
+    RecCriterion criterion; // To choose among the consistent codes found
+    int num_islands;        // Each island evolves on its own thread
+    int population_size;    // Per island
+    int max_generations;
+    int max_eligible;     // Number of consistent codes to collect before choosing
+    uint64_t deadline_us; // From timer_deadline_us, checked between generations
+} GaOptions;
+
+GaOptions ga_get_default_options();
+bool ga_find_guess(MM_Match *match, const GaOptions *options, Code_t *out_guess);
@@ -0,0 +1,339 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lies.h"
+#include "util/console.h"
+#include "util/timer.h"
+
+/*
+ * Mastermind with lies: Codes are kept on levels by the number of feedbacks they contradict.
+ * Guesses are scored over the weighted levels: After a feedback, a code that yields it stays on its level,
+ * any other code moves one level up. Codes weigh more the more lies they can still absorb.
+ */
+
+#define MIN(a, b) (a < b ? a : b)
+
+#define BLOCK_SIZE     4096 // Codes per call of the feedback kernel
+#define MAX_CANDIDATES 1024 // Guesses the recommender evaluates if there are more codes
+#define BUDGET_MS      1000 // For the recommendation shown in the game
+
+struct LiesMatch
+{
+    MM_Context *ctx;
+    int max_lies;
+    int num_turns;
+    bool won;
+    uint8_t *inconsistencies; // Per code, saturates at max_lies + 1 (eliminated)
+    Rng rng;                  // Samples the candidates of the recommender
+};
+
+// Returns NULL if the code space can't be enumerated
+LiesMatch *lm_new_match(MM_Context *ctx, int max_lies)
+{
+    if (!mm_is_enumerable(ctx) || (max_lies < 0) || (max_lies > LM_MAX_LIES))
+    {
+        return NULL;
+    }
+    LiesMatch *result = malloc(sizeof(LiesMatch));
+    *result           = (LiesMatch){ .ctx             = ctx,
+                                     .max_lies        = max_lies,
+                                     .inconsistencies = calloc(mm_get_num_codes(ctx), sizeof(uint8_t)) };
+    rng_seed(&result->rng, rng_next(mm_get_rng(ctx)));
+    return result;
+}
+
+void lm_free_match(LiesMatch *match)
+{
+    free(match->inconsistencies);
+    free(match);
+}
+
+/*
+ * Summary: Updates the counters block by block: The feedback kernel fills a block,
+ *     then a branchless loop over it increments and saturates the counters (vectorized by the compiler)
+ * Returns: Number of codes that are still possible
+ */
+CodeSize_t lm_constrain(LiesMatch *match, Code_t guess, Feedback_t feedback)
+{
+    MM_Context *ctx      = match->ctx;
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    uint8_t eliminated   = match->max_lies + 1;
+    uint8_t *counters    = match->inconsistencies;
+    match->num_turns++;
+
+    if (mm_is_winning_feedback(ctx, feedback))
+    {
+        uint8_t count = counters[guess];
+        memset(counters, eliminated, num_codes);
+        counters[guess] = count;
+        match->won      = true;
+        return 1;
+    }
+
+    Feedback_t feedbacks[BLOCK_SIZE];
+    for (Code_t first = 0; first < num_codes; first += BLOCK_SIZE)
+    {
+        CodeSize_t size = MIN(BLOCK_SIZE, num_codes - first);
+        uint8_t *block  = &counters[first];
+        mm_get_feedbacks_range(ctx, guess, first, size, feedbacks);
+        for (CodeSize_t i = 0; i < size; i++)
+        {
+            uint8_t count = block[i] + (feedbacks[i] != feedback);
+            block[i]      = (count > eliminated) ? eliminated : count;
+        }
+    }
+    counters[guess] = eliminated; // The winning feedback would have been true
+    return lm_get_remaining(match, match->max_lies);
+}
+
+MM_Context *lm_get_context(LiesMatch *match)
+{
+    return match->ctx;
+}
+
+int lm_get_max_lies(const LiesMatch *match)
+{
+    return match->max_lies;
+}
+
+int lm_get_turns(const LiesMatch *match)
+{
+    return match->num_turns;
+}
+
+MM_MatchState lm_get_state(const LiesMatch *match)
+{
+    if (match->won)
+    {
+        return MM_MATCH_WON;
+    }
+    return (match->num_turns >= mm_get_max_guesses(match->ctx)) ? MM_MATCH_LOST : MM_MATCH_PENDING;
+}
+
+// Number of codes that contradict at most max_inconsistencies feedbacks
+CodeSize_t lm_get_remaining(const LiesMatch *match, int max_inconsistencies)
+{
+    CodeSize_t result = 0;
+    for (CodeSize_t i = 0; i < mm_get_num_codes(match->ctx); i++)
+    {
+        result += (match->inconsistencies[i] <= max_inconsistencies);
+    }
+    return result;
+}
+
+int lm_get_inconsistencies(const LiesMatch *match, Code_t code)
+{
+    return match->inconsistencies[code];
+}
+
+/*
+ * Summary: Largest weight that stays possible after any feedback to guess. For each feedback f,
+ *     codes yielding f keep their weight and all others weigh as one level up. The guess itself is
+ *     the only code yielding the winning feedback and is eliminated by any other one.
+ */
+static uint64_t score_guess(LiesMatch *match, Code_t guess, const uint32_t *weights, Feedback_t *feedbacks)
+{
+    MM_Context *ctx      = match->ctx;
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    Feedback_t win       = mm_feedback_to_code(ctx, mm_get_num_slots(ctx), 0);
+    uint64_t same[MM_MAX_NUM_FEEDBACKS] = { 0 };
+    uint64_t up[MM_MAX_NUM_FEEDBACKS]   = { 0 };
+
+    for (Code_t first = 0; first < num_codes; first += BLOCK_SIZE)
+    {
+        CodeSize_t size         = MIN(BLOCK_SIZE, num_codes - first);
+        const uint8_t *counters = &match->inconsistencies[first];
+        mm_get_feedbacks_range(ctx, guess, first, size, feedbacks);
+        for (CodeSize_t i = 0; i < size; i++)
+        {
+            same[feedbacks[i]] += weights[counters[i]];
+            up[feedbacks[i]]   += weights[counters[i] + 1];
+        }
+    }
+
+    uint64_t total_up = 0;
+    for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+    {
+        total_up += up[fb];
+    }
+    uint64_t result = same[win];
+    for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+    {
+        uint64_t weight = same[fb] + total_up - up[fb] - up[win];
+        if ((fb != win) && (weight > result))
+        {
+            result = weight;
+        }
+    }
+    return result;
+}
+
+// Adds code to a reservoir of capacity MAX_CANDIDATES that has seen num_seen codes before
+static void sample_candidate(Rng *rng, Code_t code, Code_t *reservoir, CodeSize_t num_seen)
+{
+    CodeSize_t index = (num_seen < MAX_CANDIDATES) ? num_seen : rng_below(rng, num_seen + 1);
+    if (index < MAX_CANDIDATES)
+    {
+        reservoir[index] = code;
+    }
+}
+
+/*
+ * Summary: Candidates of the recommender in random order: All codes if there are at most MAX_CANDIDATES,
+ *     otherwise a uniform sample of the possible codes, topped up by a uniform sample of the others
+ */
+static CodeSize_t get_candidates(LiesMatch *match, Code_t *out_candidates)
+{
+    CodeSize_t num_codes = mm_get_num_codes(match->ctx);
+    Code_t *others       = malloc(MAX_CANDIDATES * sizeof(Code_t));
+    CodeSize_t num_poss  = 0;
+    CodeSize_t num_other = 0;
+    for (Code_t code = 0; code < num_codes; code++)
+    {
+        if (match->inconsistencies[code] <= match->max_lies)
+        {
+            sample_candidate(&match->rng, code, out_candidates, num_poss++);
+        }
+        else
+        {
+            sample_candidate(&match->rng, code, others, num_other++);
+        }
+    }
+
+    CodeSize_t result = MIN(num_poss, MAX_CANDIDATES);
+    for (CodeSize_t i = 0; (i < num_other) && (result < MAX_CANDIDATES); i++)
+    {
+        out_candidates[result++] = others[i];
+    }
+    free(others);
+
+    // Reservoirs keep codes that were never replaced in ascending order, a deadline would cut off the high ones
+    for (CodeSize_t i = result - 1; i > 0; i--)
+    {
+        CodeSize_t j      = rng_below(&match->rng, i + 1);
+        Code_t temp       = out_candidates[i];
+        out_candidates[i] = out_candidates[j];
+        out_candidates[j] = temp;
+    }
+    return result;
+}
+
+/*
+ * Summary: Guess with the smallest worst case weight among the candidates, possible codes first on ties.
+ *     Candidates are scored until the time budget is exhausted (<= 0: all), at least one is scored.
+ */
+Code_t lm_recommend(LiesMatch *match, int budget_ms)
+{
+    uint64_t deadline    = timer_deadline_us(budget_ms);
+    Code_t *candidates   = malloc(MAX_CANDIDATES * sizeof(Code_t));
+    CodeSize_t num_cands = get_candidates(match, candidates);
+
+    uint32_t weights[LM_MAX_LIES + 3];
+    for (int i = 0; i <= match->max_lies + 2; i++)
+    {
+        weights[i] = (i <= match->max_lies) ? match->max_lies - i + 1 : 0;
+    }
+
+    Feedback_t feedbacks[BLOCK_SIZE];
+    Code_t result      = (num_cands > 0) ? candidates[0] : 0;
+    uint64_t best      = UINT64_MAX;
+    bool best_possible = false;
+    for (CodeSize_t i = 0; (i < num_cands) && ((i == 0) || !timer_expired(deadline)); i++)
+    {
+        uint64_t score = score_guess(match, candidates[i], weights, feedbacks);
+        bool possible  = (match->inconsistencies[candidates[i]] <= match->max_lies);
+        if ((score < best) || ((score == best) && possible && !best_possible))
+        {
+            result        = candidates[i];
+            best          = score;
+            best_possible = possible;
+        }
+    }
+    free(candidates);
+    return result;
+}
+
+// Any wrong feedback except the winning one
+static Feedback_t get_lie(MM_Context *ctx, Feedback_t truth)
+{
+    Feedback_t result;
+    do
+    {
+        result = rng_below(mm_get_rng(ctx), mm_get_num_feedbacks(ctx));
+    } while ((result == truth) || mm_is_winning_feedback(ctx, result));
+    return result;
+}
+
+void lies(MM_Context *ctx)
+{
+    int max_lies, show_recommendation;
+    if (!mm_is_enumerable(ctx))
+    {
+        printf("Too many codes for a game with lies, choose fewer slots or colors.\n");
+        return;
+    }
+    if (!readline_int("Number of lies", 1, 0, LM_MAX_LIES, &max_lies)
+        || !readline_int("Show recommended guess", 0, 0, 1, &show_recommendation))
+    {
+        return;
+    }
+
+    LiesMatch *match              = lm_new_match(ctx, max_lies);
+    Code_t secret                 = mm_get_random_code(ctx);
+    bool lied[MM_MAX_MAX_GUESSES] = { false };
+    int lies_left                 = max_lies;
+    while (lm_get_state(match) == MM_MATCH_PENDING)
+    {
+        int turn = lm_get_turns(match);
+        if (show_recommendation)
+        {
+            printf("Recommended:");
+            print_colors(ctx, lm_recommend(match, BUDGET_MS));
+            printf("\n");
+        }
+
+        Code_t guess;
+        if (!read_colors(ctx, turn + 1, &guess))
+        {
+            break;
+        }
+
+        // Each remaining turn is equally likely to hold a lie
+        Feedback_t feedback = mm_get_feedback(ctx, guess, secret);
+        if (!mm_is_winning_feedback(ctx, feedback) && (lies_left > 0)
+            && (rng_below(mm_get_rng(ctx), mm_get_max_guesses(ctx) - turn) < (uint64_t)lies_left))
+        {
+            feedback   = get_lie(ctx, feedback);
+            lied[turn] = true;
+            lies_left--;
+        }
+
+        CodeSize_t remaining = lm_constrain(match, guess, feedback);
+        print_colors(ctx, guess);
+        print_feedback(ctx, feedback);
+        printf(" %" PRIu64 " possible (%" PRIu64 " without lies)\n", (uint64_t)remaining, (uint64_t)lm_get_remaining(match, 0));
+    }
+
+    if (lm_get_state(match) == MM_MATCH_WON)
+    {
+        printf("~ ~ You guessed right in %d turns ~ ~\n", lm_get_turns(match));
+    }
+    else
+    {
+        printf("~ ~ Game over - Solution: ");
+        print_colors(ctx, secret);
+        printf(" ~ ~\n");
+    }
+    printf("Lies in turns:");
+    for (int i = 0; i < lm_get_turns(match); i++)
+    {
+        if (lied[i])
+        {
+            printf(" %d", i + 1);
+        }
+    }
+    printf("%s\n", (lies_left == max_lies) ? " none" : "");
+    lm_free_match(match);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "mastermind.h"
+
+#define LM_MAX_LIES 3
+
+/*
+ * Match against a codemaker that may lie up to max_lies times, the winning feedback is always true.
+ * Instead of a solution space, each code has a saturating counter of feedbacks it contradicts,
+ * codes stay possible while it is at most max_lies.
+ */
+typedef struct LiesMatch LiesMatch;
+
+LiesMatch *lm_new_match(MM_Context *ctx, int max_lies);
+void lm_free_match(LiesMatch *match);
+CodeSize_t lm_constrain(LiesMatch *match, Code_t guess, Feedback_t feedback);
+MM_Context *lm_get_context(LiesMatch *match);
+int lm_get_max_lies(const LiesMatch *match);
+int lm_get_turns(const LiesMatch *match);
+MM_MatchState lm_get_state(const LiesMatch *match);
+CodeSize_t lm_get_remaining(const LiesMatch *match, int max_inconsistencies);
+int lm_get_inconsistencies(const LiesMatch *match, Code_t code);
+Code_t lm_recommend(LiesMatch *match, int budget_ms);
+
+void lies(MM_Context *ctx);
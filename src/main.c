@@ -3,7 +3,6 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <unistd.h>
 #include <readline/readline.h>
 
@@ -13,7 +12,19 @@
 #include "mastermind.h"
 #include "multiplayer/client.h"
 #include "multiplayer/server.h"
+#include "puzzle_pool.h"
 #include "quickie.h"
+#include "assistant.h"
+#include "evil.h"
+#include "lies.h"
+#include "multi_board.h"
+#include "analysis.h"
+#include "tools/analyzer.h"
+#include "tools/arena.h"
+#include "tools/bench.h"
+#include "tools/puzzles.h"
+#include "tools/simulate.h"
+#include "tools/static_set.h"
 
 #define DEFAULT_IP "127.0.0.1"
 #define PORT       25567
@@ -22,6 +33,8 @@
 #define DEFAULT_NUM_COLORS  6
 #define DEFAULT_NUM_SLOTS   4
 
+static bool show_analysis = false;
+
 static MM_Match *play_game(MM_Context *ctx, Code_t solution)
 {
     Feedback_t feedback = 0;
@@ -31,16 +44,23 @@ static MM_Match *play_game(MM_Context *ctx, Code_t solution)
         Code_t input;
         if (!read_colors(ctx, mm_get_turns(match) + 1, &input))
         {
+            an_wait();
             printf("Aborted. Solution was: ");
             print_colors(ctx, solution);
             printf("\n");
             return match;
         }
         feedback = mm_get_feedback(ctx, input, solution);
+        if (show_analysis)
+        {
+            an_start(match, input, feedback);
+        }
         mm_constrain(match, input, feedback);
         print_guess(mm_get_turns(match) - 1, match, true);
         printf("\n");
+        an_print();
     }
+    an_wait();
     print_match_end_message(match, solution, true);
     return match;
 }
@@ -110,22 +130,45 @@ static void multiplayer(MM_Context *ctx)
     }
 }
 
-static void options(MM_Context **ctx)
+// A new context restarts the puzzle pool
+static void options(MM_Context **ctx, PuzzlePool **pool)
 {
-    int max_guesses, num_slots, num_colors;
+    int max_guesses, num_slots, num_colors, rules, analysis;
     if (readline_int("Max guesses", DEFAULT_MAX_GUESSES, 2, MM_MAX_MAX_GUESSES, &max_guesses)
         && readline_int("Number of slots", DEFAULT_NUM_SLOTS, 2, MM_MAX_NUM_SLOTS, &num_slots)
-        && readline_int("Number of colors", DEFAULT_NUM_COLORS, 2, MM_MAX_NUM_COLORS, &num_colors))
+        && readline_int("Number of colors", DEFAULT_NUM_COLORS, 2, MM_MAX_NUM_COLORS, &num_colors)
+        && readline_int("Rules (0 classic, 1 no repeated colors, 2 blacks only, 3 both)", 0, 0, 3, &rules)
+        && readline_int("Show guess analysis in singleplayer", 0, 0, 1, &analysis))
     {
+        show_analysis       = (analysis == 1);
+        MM_Context *new_ctx = mm_new_ctx_rules(max_guesses, num_slots, num_colors, rules);
+        if (new_ctx == NULL)
+        {
+            if ((rules & MM_RULES_NO_REPEAT) && (num_slots > num_colors))
+            {
+                printf("Without repeated colors, there must be at least as many colors as slots.\n");
+            }
+            else if (rules != MM_RULES_CLASSIC)
+            {
+                printf("Too many codes, rule variants need an enumerable code space.\n");
+            }
+            else
+            {
+                printf("Too many codes, compile with -DMM_CODE_64 for this configuration.\n");
+            }
+            return;
+        }
+        mm_seed(new_ctx, rng_next(mm_get_rng(*ctx))); // Continues the random stream of the session
+        pp_stop(*pool);
         mm_free_ctx(*ctx);
-        *ctx = mm_new_ctx(max_guesses, num_slots, num_colors);
-        set_pending_fb_scores();
+        *ctx  = new_ctx;
+        *pool = pp_start(new_ctx, rng_next(mm_get_rng(new_ctx)));
     }
 }
 
 static void singleplayer(MM_Context *ctx)
 {
-    mm_free_match(play_game(ctx, rand() % mm_get_num_codes(ctx)));
+    mm_free_match(play_game(ctx, mm_get_random_code(ctx)));
 }
 
 static void credits()
@@ -152,15 +195,47 @@ static void credits()
     tbl_free(tbl);
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    srand(time(NULL));
+    // Command line tools: --bench [slots] [colors], --analyze file [threads], --simulate [options], --arena [options],
+    // --static [options], --puzzles [options]. Interactive session: [--seed n] replays the random choices of a session
+    if ((argc >= 2) && (strcmp(argv[1], "--bench") == 0))
+    {
+        return run_benchmark((argc >= 3) ? atoi(argv[2]) : DEFAULT_NUM_SLOTS,
+                             (argc >= 4) ? atoi(argv[3]) : DEFAULT_NUM_COLORS);
+    }
+    if ((argc >= 3) && (strcmp(argv[1], "--analyze") == 0))
+    {
+        return run_analyzer(argv[2], (argc >= 4) ? atoi(argv[3]) : 0);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "--simulate") == 0))
+    {
+        return run_simulation(argc - 2, argv + 2);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "--arena") == 0))
+    {
+        return run_arena(argc - 2, argv + 2);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "--static") == 0))
+    {
+        return run_static_set(argc - 2, argv + 2);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "--puzzles") == 0))
+    {
+        return run_puzzle_dump(argc - 2, argv + 2);
+    }
+
     MM_Context *ctx = mm_new_ctx(DEFAULT_MAX_GUESSES, DEFAULT_NUM_SLOTS, DEFAULT_NUM_COLORS);
+    if ((argc >= 3) && (strcmp(argv[1], "--seed") == 0))
+    {
+        mm_seed(ctx, strtoull(argv[2], NULL, 10));
+    }
+    PuzzlePool *pool = pp_start(ctx, rng_next(mm_get_rng(ctx))); // Fast mode puzzles are generated while in the menu
     printf("~ ~ Mastermind ~ ~\n");
 
     while (true)
     {
-        char *input = readline("(s)ingleplayer, (m)ultiplayer, (f)ast, (o)ptions or (e)xit? ");
+        char *input = readline("(s)ingleplayer, (m)ultiplayer, (f)ast, e(v)il, (l)ies, (b)oards, (a)ssistant, (o)ptions or (e)xit? ");
         clear_input();
         bool exit = false;
 
@@ -181,10 +256,22 @@ int main()
                     multiplayer(ctx);
                     break;
                 case 'f':
-                    quickie(ctx);
+                    quickie(ctx, pool);
+                    break;
+                case 'v':
+                    evil(ctx);
+                    break;
+                case 'l':
+                    lies(ctx);
+                    break;
+                case 'b':
+                    multi_board(ctx);
+                    break;
+                case 'a':
+                    assistant(ctx);
                     break;
                 case 'o':
-                    options(&ctx);
+                    options(&ctx, &pool);
                     break;
                 case 'c':
                     credits();
@@ -202,6 +289,7 @@ int main()
         }
     }
 
+    pp_stop(pool);
     mm_free_ctx(ctx);
     return 0;
 }
@@ -1,27 +1,40 @@
+#define _DEFAULT_SOURCE
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
 
 #include "mastermind.h"
+#include "consistent.h"
+#include "feedback_table.h"
+#include "util/code_set.h"
 #include "util/string_util.h"
 
 #define MIN(a, b) (a < b ? a : b)
 
+#define MAX_STATS_THREADS 64
+
 struct MM_Context
 {
     int max_guesses;
     int num_slots;
     int num_colors;
+    int rules; // MM_Rules
     FeedbackSize_t num_feedbacks;
     CodeSize_t num_codes;
-    Feedback_t feedback_encode[MM_MAX_NUM_SLOTS + 1][MM_MAX_NUM_SLOTS + 1];
-    uint16_t feedback_decode[MM_MAX_NUM_FEEDBACKS];
+    Feedback_t *feedback_encode; // (num_slots + 1)^2, index b * (num_slots + 1) + w
+    uint16_t *feedback_decode;   // num_feedbacks
 
     // Optional
     bool fb_lookup_initialized;
     Feedback_t *feedback_lookup;
+    MM_FeedbackStats *feedback_stats; // Computed on first use
+
+    uint64_t seed;
+    Rng rng;              // Draws of mm_get_random_code, not shared with matches
+    uint64_t num_matches; // Derives the seeds of new matches, atomic
 };
 
 struct MM_Match
@@ -31,8 +44,10 @@ struct MM_Match
     Feedback_t feedbacks[MM_MAX_MAX_GUESSES];
     Code_t guesses[MM_MAX_MAX_GUESSES];
     bool enable_recommendation;
+    bool symbolic_counting; // Solution space could not be enumerated, solutions are counted by csp_count_consistent
     CodeSize_t num_solutions;
-    bool *solution_space; // On heap
+    CodeSet *solution_space; // On heap
+    Rng rng;                 // Random choices of solvers playing this match
 };
 
 static Feedback_t calculate_fb(MM_Context *ctx, Code_t a, Code_t b)
@@ -41,11 +56,15 @@ static Feedback_t calculate_fb(MM_Context *ctx, Code_t a, Code_t b)
     int num_w                             = 0;
     int color_counts_a[MM_MAX_NUM_COLORS] = { 0 };
     int color_counts_b[MM_MAX_NUM_COLORS] = { 0 };
+    int colors_a[MM_MAX_NUM_SLOTS];
+    int colors_b[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, a, colors_a);
+    mm_code_to_colors(ctx, b, colors_b);
 
     for (int i = 0; i < ctx->num_slots; i++)
     {
-        int col_a = mm_get_color_at_pos(ctx->num_colors, a, i);
-        int col_b = mm_get_color_at_pos(ctx->num_colors, b, i);
+        int col_a = colors_a[i];
+        int col_b = colors_b[i];
         color_counts_a[col_a]++;
         color_counts_b[col_b]++;
         if (col_a == col_b)
@@ -60,25 +79,121 @@ static Feedback_t calculate_fb(MM_Context *ctx, Code_t a, Code_t b)
     }
     num_w -= num_b;
 
-    return ctx->feedback_encode[num_b][num_w];
+    return mm_feedback_to_code(ctx, num_b, num_w);
 }
 
-void mm_init_feedback_lookup(MM_Context *ctx)
+/*
+ * Summary: Builds table of feedbacks for all pairs of codes
+ * Returns: False if there are too many codes for a table, feedbacks are calculated on the fly then
+ */
+bool mm_init_feedback_lookup(MM_Context *ctx)
 {
     if (ctx->fb_lookup_initialized)
     {
-        return;
+        return true;
+    }
+    if (ctx->num_codes > MM_MAX_LOOKUP_CODES)
+    {
+        return false;
+    }
+    ctx->feedback_lookup = malloc((size_t)ctx->num_codes * ctx->num_codes * sizeof(Feedback_t));
+    if (ctx->feedback_lookup == NULL)
+    {
+        return false;
     }
-    ctx->fb_lookup_initialized = true;
-    ctx->feedback_lookup       = malloc(ctx->num_codes * ctx->num_codes * sizeof(Code_t));
     for (Code_t a = 0; a < ctx->num_codes; a++)
     {
-        for (Code_t b = 0; b <= a; b++)
+        mm_get_feedbacks_range(ctx, a, 0, ctx->num_codes, &ctx->feedback_lookup[(size_t)a * ctx->num_codes]);
+    }
+    ctx->fb_lookup_initialized = true;
+    return true;
+}
+
+typedef struct
+{
+    MM_Context *ctx;
+    int index;
+    int num_threads;
+    MM_FeedbackStats stats;
+} StatsWorker;
+
+static void *run_stats_worker(void *arg)
+{
+    StatsWorker *worker = arg;
+    MM_Context *ctx     = worker->ctx;
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+    for (Code_t a = worker->index; a < ctx->num_codes; a += worker->num_threads)
+    {
+        mm_get_partition_range(ctx, a, 0, ctx->num_codes, counts);
+        for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
         {
-            ctx->feedback_lookup[a * ctx->num_codes + b] = calculate_fb(ctx, a, b);
-            ctx->feedback_lookup[b * ctx->num_codes + a] = ctx->feedback_lookup[a * ctx->num_codes + b];
+            worker->stats.num_pairs[fb] += counts[fb];
+            worker->stats.num_hits[fb]  += (counts[fb] != 0);
         }
     }
+    return NULL;
+}
+
+/*
+ * Summary: Statistics of feedbacks over all pairs of codes. In closed form where possible, otherwise in one pass:
+ *     The partition of the code space by each code gives its pair counts and whether it yields each feedback,
+ *     codes are sharded across threads. Computed on the first call and cached in the context,
+ *     call before the context is shared between threads.
+ * Returns: NULL if there is no closed form and the code space can't be enumerated
+ */
+const MM_FeedbackStats *mm_get_feedback_stats(MM_Context *ctx)
+{
+    if (ctx->feedback_stats != NULL)
+    {
+        return ctx->feedback_stats;
+    }
+    ctx->feedback_stats = malloc(sizeof(MM_FeedbackStats));
+    if (ft_get_stats(ctx, ctx->feedback_stats))
+    {
+        return ctx->feedback_stats;
+    }
+    free(ctx->feedback_stats);
+    ctx->feedback_stats = NULL;
+    if (!mm_is_enumerable(ctx))
+    {
+        return NULL;
+    }
+
+    long num_cores  = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = (num_cores < 1) ? 1 : ((num_cores > MAX_STATS_THREADS) ? MAX_STATS_THREADS : num_cores);
+    num_threads     = ((CodeSize_t)num_threads > ctx->num_codes) ? (int)ctx->num_codes : num_threads;
+    pthread_t threads[MAX_STATS_THREADS];
+    bool started[MAX_STATS_THREADS];
+    StatsWorker *workers = calloc(num_threads, sizeof(StatsWorker));
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i] = (StatsWorker){ .ctx = ctx, .index = i, .num_threads = num_threads };
+        started[i] = (pthread_create(&threads[i], NULL, run_stats_worker, &workers[i]) == 0);
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        // Out of threads: The shard is computed on this one
+        if (!started[i])
+        {
+            run_stats_worker(&workers[i]);
+        }
+    }
+
+    ctx->feedback_stats = calloc(1, sizeof(MM_FeedbackStats));
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+        for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
+        {
+            ctx->feedback_stats->num_pairs[fb] += workers[i].stats.num_pairs[fb];
+            ctx->feedback_stats->num_hits[fb]  += workers[i].stats.num_hits[fb];
+        }
+    }
+    free(workers);
+    return ctx->feedback_stats;
 }
 
 /*
@@ -95,50 +210,98 @@ MM_Match *mm_new_match(MM_Context *ctx, bool enable_recommendation)
                           .solution_space        = NULL,
                           .num_turns             = 0,
                           .num_solutions         = 0,
-                          .enable_recommendation = enable_recommendation };
+                          .enable_recommendation = enable_recommendation,
+                          .symbolic_counting     = false };
+    mm_seed_match(result, ctx->seed + __atomic_add_fetch(&ctx->num_matches, 1, __ATOMIC_RELAXED));
 
     if (enable_recommendation)
     {
-        result->num_solutions  = ctx->num_codes;
-        result->solution_space = malloc(ctx->num_codes * sizeof(bool));
-        if (result->solution_space == NULL)
+        result->num_solutions = ctx->num_codes;
+        if (mm_is_enumerable(ctx))
         {
-            result->enable_recommendation = false;
-            return result;
+            result->solution_space = cs_new_full(ctx->num_codes);
         }
-        for (CodeSize_t i = 0; i < ctx->num_codes; i++)
+        if (result->solution_space == NULL)
         {
-            result->solution_space[i] = true;
+            result->symbolic_counting = true;
         }
     }
     return result;
 }
 
+/*
+ * Summary: Creates context of classic game rules
+ * Returns: NULL if limits are exceeded or number of codes doesn't fit into Code_t
+ */
 MM_Context *mm_new_ctx(int max_guesses, int num_slots, int num_colors)
 {
-    FeedbackSize_t num_feedbacks = num_slots * (num_slots / 2.0 + 1.5);
+    return mm_new_ctx_rules(max_guesses, num_slots, num_colors, MM_RULES_CLASSIC);
+}
+
+/*
+ * Summary: Creates context of game rules with variants (MM_Rules combined by |)
+ * Returns: NULL if limits are exceeded, number of codes doesn't fit into Code_t
+ *     or a variant's code space is too large to be enumerated
+ */
+MM_Context *mm_new_ctx_rules(int max_guesses, int num_slots, int num_colors, int rules)
+{
+    bool no_repeat               = (rules & MM_RULES_NO_REPEAT) != 0;
+    bool black_only              = (rules & MM_RULES_BLACK_ONLY) != 0;
+    FeedbackSize_t num_feedbacks = black_only ? num_slots + 1 : num_slots * (num_slots + 3) / 2;
 
-    if ((num_slots > MM_MAX_NUM_SLOTS) || (num_colors > MM_MAX_NUM_COLORS) || (num_feedbacks > MM_MAX_NUM_FEEDBACKS) || (max_guesses > MM_MAX_MAX_GUESSES))
+    if ((num_slots < 1) || (num_colors < 1) || (max_guesses < 1)
+        || (num_slots > MM_MAX_NUM_SLOTS) || (num_colors > MM_MAX_NUM_COLORS) || (max_guesses > MM_MAX_MAX_GUESSES)
+        || (no_repeat && (num_slots > num_colors)))
+    {
+        return NULL;
+    }
+
+    // Without repetition, the i-th slot has num_colors - i choices left
+    CodeSize_t num_codes = 1;
+    for (int i = 0; i < num_slots; i++)
+    {
+        CodeSize_t choices = no_repeat ? num_colors - i : num_colors;
+        if (num_codes > ((CodeSize_t)-1) / choices)
+        {
+            return NULL;
+        }
+        num_codes *= choices;
+    }
+    if ((rules != MM_RULES_CLASSIC) && (num_codes > MM_MAX_ENUMERATED_CODES))
     {
         return NULL;
     }
 
     MM_Context *ctx = malloc(sizeof(MM_Context));
-    *ctx            = (MM_Context){ .max_guesses   = max_guesses,
-                                    .num_slots     = num_slots,
-                                    .num_colors    = num_colors,
-                                    .num_feedbacks = num_feedbacks,
-                                    .num_codes     = pow(num_colors, num_slots) };
+    *ctx            = (MM_Context){ .max_guesses     = max_guesses,
+                                    .num_slots       = num_slots,
+                                    .num_colors      = num_colors,
+                                    .rules           = rules,
+                                    .num_feedbacks   = num_feedbacks,
+                                    .num_codes       = num_codes,
+                                    .feedback_encode = malloc((num_slots + 1) * (num_slots + 1) * sizeof(Feedback_t)),
+                                    .feedback_decode = malloc(num_feedbacks * sizeof(uint16_t)) };
+    mm_seed(ctx, rng_get_entropy());
 
     FeedbackSize_t counter = 0;
     for (int b = 0; b <= num_slots; b++)
     {
+        if (black_only)
+        {
+            // Whites are dropped, so kernels that count them still yield the right feedback
+            for (int w = 0; w <= num_slots; w++)
+            {
+                ctx->feedback_encode[b * (num_slots + 1) + w] = counter;
+            }
+            ctx->feedback_decode[counter++] = b << 8;
+            continue;
+        }
         for (int w = 0; w <= num_slots; w++)
         {
             if ((b + w) <= num_slots && !(b == num_slots - 1 && w == 1))
             {
-                ctx->feedback_encode[b][w]    = counter;
-                ctx->feedback_decode[counter] = (b << 8) | w;
+                ctx->feedback_encode[b * (num_slots + 1) + w] = counter;
+                ctx->feedback_decode[counter]                 = (b << 8) | w;
                 counter++;
             }
         }
@@ -153,6 +316,9 @@ void mm_free_ctx(MM_Context *ctx)
     {
         free(ctx->feedback_lookup);
     }
+    free(ctx->feedback_stats);
+    free(ctx->feedback_encode);
+    free(ctx->feedback_decode);
     free(ctx);
 }
 
@@ -164,14 +330,14 @@ void mm_code_to_feedback(MM_Context *ctx, Feedback_t fb_code, int *b, int *w)
 
 Feedback_t mm_feedback_to_code(MM_Context *ctx, int b, int w)
 {
-    return ctx->feedback_encode[b][w];
+    return ctx->feedback_encode[b * (ctx->num_slots + 1) + w];
 }
 
 Feedback_t mm_get_feedback(MM_Context *ctx, Code_t a, Code_t b)
 {
     if (ctx->fb_lookup_initialized)
     {
-        return ctx->feedback_lookup[a * ctx->num_codes + b];
+        return ctx->feedback_lookup[(size_t)a * ctx->num_codes + b];
     }
     else
     {
@@ -181,22 +347,91 @@ Feedback_t mm_get_feedback(MM_Context *ctx, Code_t a, Code_t b)
 
 bool mm_is_winning_feedback(MM_Context *ctx, Feedback_t fb)
 {
-    return fb == ctx->feedback_encode[ctx->num_slots][0];
+    return fb == mm_feedback_to_code(ctx, ctx->num_slots, 0);
 }
 
+// Whether colors form a code of the rules of ctx
+bool mm_is_valid_colors(MM_Context *ctx, const int *colors)
+{
+    uint32_t used = 0;
+    for (int i = 0; i < ctx->num_slots; i++)
+    {
+        if ((colors[i] < 0) || (colors[i] >= ctx->num_colors)
+            || ((ctx->rules & MM_RULES_NO_REPEAT) && (used & (1u << colors[i]))))
+        {
+            return false;
+        }
+        used |= 1u << colors[i];
+    }
+    return true;
+}
+
+/*
+ * Classic codes are base num_colors numbers, slot 0 being the lowest digit.
+ * Without repetition, slot i is the rank of its color among the colors not used by lower slots,
+ * a digit of base num_colors - i. The num_colors! / (num_colors - num_slots)! codes are ranked densely.
+ */
 Code_t mm_colors_to_code(MM_Context *ctx, int *colors)
 {
     Code_t result = 0;
-    for (int i = 0; i < mm_get_num_slots(ctx); i++)
+    if (ctx->rules & MM_RULES_NO_REPEAT)
+    {
+        uint32_t used      = 0;
+        Code_t place_value = 1;
+        for (int i = 0; i < ctx->num_slots; i++)
+        {
+            int rank = colors[i];
+            for (uint32_t lower = used & ((1u << colors[i]) - 1); lower != 0; lower &= lower - 1)
+            {
+                rank--;
+            }
+            result      += rank * place_value;
+            place_value *= ctx->num_colors - i;
+            used        |= 1u << colors[i];
+        }
+        return result;
+    }
+
+    for (int i = ctx->num_slots - 1; i >= 0; i--)
     {
-        result += colors[i] * pow(mm_get_num_colors(ctx), i);
+        result = result * ctx->num_colors + colors[i];
     }
     return result;
 }
 
-int mm_get_color_at_pos(int num_colors, Code_t code, int index)
+void mm_code_to_colors(MM_Context *ctx, Code_t code, int *out_colors)
 {
-    return (int)(code / pow(num_colors, index)) % num_colors;
+    if (ctx->rules & MM_RULES_NO_REPEAT)
+    {
+        uint32_t used = 0;
+        for (int i = 0; i < ctx->num_slots; i++)
+        {
+            int rank = code % (ctx->num_colors - i);
+            code /= ctx->num_colors - i;
+
+            int col = 0;
+            while ((used & (1u << col)) || (rank-- > 0))
+            {
+                col++;
+            }
+            out_colors[i] = col;
+            used |= 1u << col;
+        }
+        return;
+    }
+
+    for (int i = 0; i < ctx->num_slots; i++)
+    {
+        out_colors[i] = code % ctx->num_colors;
+        code /= ctx->num_colors;
+    }
+}
+
+int mm_get_color_at_pos(MM_Context *ctx, Code_t code, int index)
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, code, colors);
+    return colors[index];
 }
 
 int mm_get_max_guesses(MM_Context *ctx)
@@ -224,43 +459,102 @@ int mm_get_num_feedbacks(MM_Context *ctx)
     return ctx->num_feedbacks;
 }
 
-void mm_free_match(MM_Match *match)
+int mm_get_rules(MM_Context *ctx)
 {
-    free(match->solution_space);
-    free(match);
+    return ctx->rules;
 }
 
-CodeSize_t mm_constrain(MM_Match *match, Code_t guess, Feedback_t feedback)
+// Whether matches can hold the full solution space, otherwise solutions are counted symbolically
+bool mm_is_enumerable(MM_Context *ctx)
 {
-    match->guesses[match->num_turns]   = guess;
-    match->feedbacks[match->num_turns] = feedback;
-    match->num_turns++;
-    CodeSize_t result = 0;
+    return ctx->num_codes <= MM_MAX_ENUMERATED_CODES;
+}
 
-    if (match->enable_recommendation)
+/*
+ * Summary: Restarts the random streams of ctx: Its own draws and the seeds of matches created afterwards
+ *     follow from seed, a fresh context is seeded from the clock
+ */
+void mm_seed(MM_Context *ctx, uint64_t seed)
+{
+    ctx->seed        = seed;
+    ctx->num_matches = 0;
+    rng_seed(&ctx->rng, seed);
+}
+
+uint64_t mm_get_seed(MM_Context *ctx)
+{
+    return ctx->seed;
+}
+
+// Not thread safe, threads draw from their own Rng by mm_draw_code
+Rng *mm_get_rng(MM_Context *ctx)
+{
+    return &ctx->rng;
+}
+
+// Uniform random code of the rules of ctx, doesn't modify ctx
+Code_t mm_draw_code(MM_Context *ctx, Rng *rng)
+{
+    if (ctx->rules & MM_RULES_NO_REPEAT)
     {
-        CodeSize_t remaining = 0;
-        for (CodeSize_t i = 0; i < match->ctx->num_codes; i++)
-        {
-            if (match->solution_space[i])
-            {
-                if (mm_get_feedback(match->ctx, guess, i) != feedback)
-                {
-                    match->solution_space[i] = false;
-                    result++;
-                }
-                else
-                {
-                    remaining++;
-                }
-            }
-        }
-        match->num_solutions = remaining;
+        return rng_below(rng, ctx->num_codes); // Ranked permutations, so every code is valid
     }
 
+    int colors[MM_MAX_NUM_SLOTS];
+    for (int i = 0; i < ctx->num_slots; i++)
+    {
+        colors[i] = rng_below(rng, ctx->num_colors);
+    }
+    return mm_colors_to_code(ctx, colors);
+}
+
+Code_t mm_get_random_code(MM_Context *ctx)
+{
+    return mm_draw_code(ctx, &ctx->rng);
+}
+
+// Independent copy of match, e.g. to be analyzed on another thread
+MM_Match *mm_copy_match(const MM_Match *match)
+{
+    MM_Match *result = malloc(sizeof(MM_Match));
+    *result          = *match;
+    if (match->solution_space != NULL)
+    {
+        result->solution_space = cs_copy(match->solution_space);
+    }
     return result;
 }
 
+// A match is seeded from its context and creation order, simulations seed by secret to be independent of threads
+void mm_seed_match(MM_Match *match, uint64_t seed)
+{
+    rng_seed(&match->rng, seed);
+}
+
+Rng *mm_get_match_rng(MM_Match *match)
+{
+    return &match->rng;
+}
+
+void mm_free_match(MM_Match *match)
+{
+    cs_free(match->solution_space);
+    free(match);
+}
+
+CodeSize_t mm_constrain(MM_Match *match, Code_t guess, Feedback_t feedback)
+{
+    MM_ConstrainRequest request = { .match = match, .guess = guess, .feedback = feedback };
+    mm_constrain_batch(match->ctx, &request, 1);
+    return request.num_eliminated;
+}
+
+// Heap memory held by match in bytes
+size_t mm_get_match_memory(const MM_Match *match)
+{
+    return sizeof(MM_Match) + ((match->solution_space != NULL) ? cs_get_memory(match->solution_space) : 0);
+}
+
 MM_Context *mm_get_context(MM_Match *match)
 {
     return match->ctx;
@@ -313,5 +607,627 @@ bool mm_is_solution_counting_enabled(const MM_Match *match)
 
 bool mm_is_in_solution(const MM_Match *match, Code_t code)
 {
-    return match->solution_space[code];
+    if (match->symbolic_counting)
+    {
+        for (int i = 0; i < match->num_turns; i++)
+        {
+            if (mm_get_feedback(match->ctx, match->guesses[i], code) != match->feedbacks[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return cs_contains(match->solution_space, code);
+}
+
+// Writes all codes that are still possible into out_codes (size must be at least mm_get_remaining_solutions)
+CodeSize_t mm_get_solutions(const MM_Match *match, Code_t *out_codes)
+{
+    if (!match->symbolic_counting)
+    {
+        return cs_get_codes(match->solution_space, out_codes);
+    }
+
+    CodeSize_t count = 0;
+    for (CodeSize_t i = 0; i < match->ctx->num_codes; i++)
+    {
+        if (mm_is_in_solution(match, i))
+        {
+            out_codes[count++] = i;
+        }
+    }
+    return count;
+}
+
+/*
+ * Summary: Uniform random sample of at most max_samples remaining solutions in random order, by reservoir
+ *     sampling with geometric skips (Li's algorithm L). Chunks are skipped by their counts and only decoded
+ *     if they hold a sampled solution, memory is O(max_samples) plus one chunk.
+ * Returns: Number of sampled solutions, 0 if the solution space isn't enumerated
+ */
+CodeSize_t mm_sample_solutions(const MM_Match *match, Rng *rng, CodeSize_t max_samples, Code_t *out_sample)
+{
+    const CodeSet *space = match->solution_space;
+    if (space == NULL)
+    {
+        return 0;
+    }
+    CodeSize_t num_sols = cs_count(space);
+    CodeSize_t result   = MIN(num_sols, max_samples);
+    if (result == 0)
+    {
+        return 0;
+    }
+
+    Code_t *codes    = malloc(CS_CHUNK_SIZE * sizeof(Code_t));
+    double w         = exp(log(rng_uniform(rng)) / result);
+    CodeSize_t next  = 0; // Rank of the next solution that enters the reservoir
+    CodeSize_t first = 0; // Rank of the first solution of chunk
+    for (size_t chunk = 0; (chunk < cs_get_num_chunks(space)) && (next < num_sols); chunk++)
+    {
+        uint32_t count = cs_get_chunk_count(space, chunk);
+        if (next >= first + count)
+        {
+            first += count;
+            continue;
+        }
+        cs_get_chunk_codes(space, chunk, codes);
+        while (next < first + count)
+        {
+            out_sample[(next < result) ? next : rng_below(rng, result)] = codes[next - first];
+            if (next + 1 < result)
+            {
+                next++;
+                continue;
+            }
+            if (next >= result)
+            {
+                w *= exp(log(rng_uniform(rng)) / result);
+            }
+            double skip = floor(log(rng_uniform(rng)) / log1p(-w));
+            next        = (skip < (double)(num_sols - next)) ? next + (CodeSize_t)skip + 1 : num_sols;
+        }
+        first += count;
+    }
+    free(codes);
+
+    // Solutions that were never replaced are still in ascending order, callers use prefixes of the sample
+    for (CodeSize_t i = result - 1; i > 0; i--)
+    {
+        CodeSize_t j  = rng_below(rng, i + 1);
+        Code_t temp   = out_sample[i];
+        out_sample[i] = out_sample[j];
+        out_sample[j] = temp;
+    }
+    return result;
+}
+
+// Guess decoded once, to be compared against many codes
+typedef struct
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    int counts[MM_MAX_NUM_COLORS];
+    int positions[MM_MAX_NUM_COLORS]; // Slot of each color, -1 if not in guess (MM_RULES_NO_REPEAT)
+} PreparedGuess;
+
+static void prepare_guess(MM_Context *ctx, Code_t guess, PreparedGuess *out_prepared)
+{
+    *out_prepared = (PreparedGuess){ 0 };
+    mm_code_to_colors(ctx, guess, out_prepared->colors);
+    for (int i = 0; i < ctx->num_colors; i++)
+    {
+        out_prepared->positions[i] = -1;
+    }
+    for (int i = 0; i < ctx->num_slots; i++)
+    {
+        out_prepared->counts[out_prepared->colors[i]]++;
+        out_prepared->positions[out_prepared->colors[i]] = i;
+    }
+}
+
+// Kernels of the rule variants, code already decoded
+static Feedback_t variant_fb(MM_Context *ctx, const PreparedGuess *guess, const int *colors)
+{
+    int num_b = 0;
+    if (ctx->rules & MM_RULES_BLACK_ONLY)
+    {
+        for (int j = 0; j < ctx->num_slots; j++)
+        {
+            num_b += (colors[j] == guess->colors[j]);
+        }
+        return mm_feedback_to_code(ctx, num_b, 0);
+    }
+
+    // No repetition: Each color of the code matches at most once, iff the guess contains it
+    int num_bw = 0;
+    for (int j = 0; j < ctx->num_slots; j++)
+    {
+        int position = guess->positions[colors[j]];
+        num_b  += (position == j);
+        num_bw += (position >= 0);
+    }
+    return mm_feedback_to_code(ctx, num_b, num_bw - num_b);
+}
+
+static Feedback_t prepared_fb(MM_Context *ctx, const PreparedGuess *guess, Code_t code)
+{
+    if (ctx->rules != MM_RULES_CLASSIC)
+    {
+        int colors[MM_MAX_NUM_SLOTS];
+        mm_code_to_colors(ctx, code, colors);
+        return variant_fb(ctx, guess, colors);
+    }
+
+    int num_b                     = 0;
+    int num_bw                    = 0;
+    int counts[MM_MAX_NUM_COLORS] = { 0 };
+    for (int j = 0; j < ctx->num_slots; j++)
+    {
+        int col = code % ctx->num_colors;
+        code /= ctx->num_colors;
+        if (col == guess->colors[j])
+        {
+            num_b++;
+        }
+        if (counts[col] < guess->counts[col])
+        {
+            num_bw++;
+        }
+        counts[col]++;
+    }
+    return mm_feedback_to_code(ctx, num_b, num_bw - num_b);
+}
+
+// Calculates feedback of guess against each of the given codes (batched)
+void mm_get_feedbacks(MM_Context *ctx, Code_t guess, const Code_t *codes, CodeSize_t num_codes, Feedback_t *out_feedbacks)
+{
+    if (ctx->fb_lookup_initialized)
+    {
+        const Feedback_t *row = &ctx->feedback_lookup[(size_t)guess * ctx->num_codes];
+        for (CodeSize_t i = 0; i < num_codes; i++)
+        {
+            out_feedbacks[i] = row[codes[i]];
+        }
+        return;
+    }
+
+    PreparedGuess prepared;
+    prepare_guess(ctx, guess, &prepared);
+    for (CodeSize_t i = 0; i < num_codes; i++)
+    {
+        out_feedbacks[i] = prepared_fb(ctx, &prepared, codes[i]);
+    }
+}
+
+// Counts for each feedback how many of the given codes would yield it when guess is played (one pass)
+void mm_get_partition(MM_Context *ctx, Code_t guess, const Code_t *codes, CodeSize_t num_codes, CodeSize_t *out_counts)
+{
+    for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
+    {
+        out_counts[fb] = 0;
+    }
+
+    if (ctx->fb_lookup_initialized)
+    {
+        const Feedback_t *row = &ctx->feedback_lookup[(size_t)guess * ctx->num_codes];
+        for (CodeSize_t i = 0; i < num_codes; i++)
+        {
+            out_counts[row[codes[i]]]++;
+        }
+        return;
+    }
+
+    PreparedGuess prepared;
+    prepare_guess(ctx, guess, &prepared);
+    for (CodeSize_t i = 0; i < num_codes; i++)
+    {
+        out_counts[prepared_fb(ctx, &prepared, codes[i])]++;
+    }
+}
+
+/*
+ * Summary: Starts a Gray walk over all codes that share the higher slots of first,
+ *     the lowest num_digits slots of first must be 0 (aligned block of num_colors^num_digits codes)
+ */
+void mm_gray_begin(MM_Context *ctx, Code_t guess, Code_t first, int num_digits, MM_GrayWalk *out_walk)
+{
+    *out_walk = (MM_GrayWalk){ .ctx        = ctx,
+                               .num_digits = (ctx->num_colors > 1) ? num_digits : 0,
+                               .code       = first };
+
+    mm_code_to_colors(ctx, guess, out_walk->guess_colors);
+    mm_code_to_colors(ctx, first, out_walk->colors);
+    Code_t place_value = 1;
+    for (int i = 0; i < ctx->num_slots; i++)
+    {
+        out_walk->place_values[i] = place_value;
+        out_walk->directions[i]   = 1;
+        out_walk->focus[i]        = i;
+        place_value *= ctx->num_colors;
+        out_walk->guess_counts[out_walk->guess_colors[i]]++;
+        out_walk->code_counts[out_walk->colors[i]]++;
+        if (out_walk->colors[i] == out_walk->guess_colors[i])
+        {
+            out_walk->num_b++;
+        }
+    }
+    out_walk->focus[ctx->num_slots] = ctx->num_slots;
+
+    for (int i = 0; i < ctx->num_colors; i++)
+    {
+        out_walk->num_bw += MIN(out_walk->guess_counts[i], out_walk->code_counts[i]);
+    }
+}
+
+/*
+ * Summary: Advances to the next code of the block (loopless reflected mixed-radix Gray code)
+ * Returns: False if all codes of the block have been visited
+ */
+bool mm_gray_next(MM_GrayWalk *walk)
+{
+    int j          = walk->focus[0];
+    walk->focus[0] = 0;
+    if (j == walk->num_digits)
+    {
+        return false;
+    }
+
+    int old_col = walk->colors[j];
+    int new_col = old_col + walk->directions[j];
+    if (walk->directions[j] > 0)
+    {
+        walk->code += walk->place_values[j];
+    }
+    else
+    {
+        walk->code -= walk->place_values[j];
+    }
+    walk->colors[j] = new_col;
+
+    // Update blacks and blacks + whites with the changed slot only
+    if (old_col == walk->guess_colors[j])
+    {
+        walk->num_b--;
+    }
+    if (new_col == walk->guess_colors[j])
+    {
+        walk->num_b++;
+    }
+    if (walk->code_counts[old_col] <= walk->guess_counts[old_col])
+    {
+        walk->num_bw--;
+    }
+    walk->code_counts[old_col]--;
+    if (walk->code_counts[new_col] < walk->guess_counts[new_col])
+    {
+        walk->num_bw++;
+    }
+    walk->code_counts[new_col]++;
+
+    if ((new_col == 0) || (new_col == walk->ctx->num_colors - 1))
+    {
+        walk->directions[j] = -walk->directions[j];
+        walk->focus[j]      = walk->focus[j + 1];
+        walk->focus[j + 1]  = j + 1;
+    }
+    return true;
+}
+
+Feedback_t mm_gray_get_feedback(const MM_GrayWalk *walk)
+{
+    return mm_feedback_to_code(walk->ctx, walk->num_b, walk->num_bw - walk->num_b);
+}
+
+// Number of low slots of the largest aligned block that starts at first and has at most max_codes codes
+static int get_block_digits(MM_Context *ctx, Code_t first, CodeSize_t max_codes, CodeSize_t *out_size)
+{
+    int digits      = 0;
+    CodeSize_t size = 1;
+    while ((digits < ctx->num_slots) && (first % (size * ctx->num_colors) == 0) && (size * ctx->num_colors <= max_codes))
+    {
+        size *= ctx->num_colors;
+        digits++;
+    }
+    *out_size = size;
+    return digits;
+}
+
+// Calculates feedback of guess against the codes first, ..., first + num_codes - 1 by Gray walks over aligned blocks
+void mm_get_feedbacks_range(MM_Context *ctx, Code_t guess, Code_t first, CodeSize_t num_codes, Feedback_t *out_feedbacks)
+{
+    if (ctx->rules & MM_RULES_NO_REPEAT)
+    {
+        PreparedGuess prepared;
+        prepare_guess(ctx, guess, &prepared);
+        for (CodeSize_t i = 0; i < num_codes; i++)
+        {
+            out_feedbacks[i] = prepared_fb(ctx, &prepared, first + i);
+        }
+        return;
+    }
+
+    CodeSize_t done = 0;
+    while (done < num_codes)
+    {
+        CodeSize_t block_size;
+        MM_GrayWalk walk;
+        mm_gray_begin(ctx, guess, first + done, get_block_digits(ctx, first + done, num_codes - done, &block_size), &walk);
+        do
+        {
+            out_feedbacks[walk.code - first] = mm_gray_get_feedback(&walk);
+        } while (mm_gray_next(&walk));
+        done += block_size;
+    }
+}
+
+// Like mm_get_partition, but for the codes first, ..., first + num_codes - 1
+void mm_get_partition_range(MM_Context *ctx, Code_t guess, Code_t first, CodeSize_t num_codes, CodeSize_t *out_counts)
+{
+    for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
+    {
+        out_counts[fb] = 0;
+    }
+
+    if (ctx->fb_lookup_initialized)
+    {
+        const Feedback_t *row = &ctx->feedback_lookup[(size_t)guess * ctx->num_codes + first];
+        for (CodeSize_t i = 0; i < num_codes; i++)
+        {
+            out_counts[row[i]]++;
+        }
+        return;
+    }
+    if (ctx->rules & MM_RULES_NO_REPEAT)
+    {
+        PreparedGuess prepared;
+        prepare_guess(ctx, guess, &prepared);
+        for (CodeSize_t i = 0; i < num_codes; i++)
+        {
+            out_counts[prepared_fb(ctx, &prepared, first + i)]++;
+        }
+        return;
+    }
+
+    CodeSize_t done = 0;
+    while (done < num_codes)
+    {
+        CodeSize_t block_size;
+        MM_GrayWalk walk;
+        mm_gray_begin(ctx, guess, first + done, get_block_digits(ctx, first + done, num_codes - done, &block_size), &walk);
+        do
+        {
+            out_counts[mm_gray_get_feedback(&walk)]++;
+        } while (mm_gray_next(&walk));
+        done += block_size;
+    }
+}
+
+/*
+ * Summary: Like mm_get_partition for the remaining solutions of match, without extracting them first:
+ *     Full chunks of the solution space are partitioned by Gray walk, others code by code.
+ *     Solution counting must be enabled and the code space enumerable.
+ */
+void mm_get_solution_partition(MM_Match *match, Code_t guess, CodeSize_t *out_counts)
+{
+    MM_Context *ctx = match->ctx;
+    for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
+    {
+        out_counts[fb] = 0;
+    }
+
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+    Code_t *codes = NULL;
+    for (size_t chunk = 0; chunk < cs_get_num_chunks(match->solution_space); chunk++)
+    {
+        Code_t chunk_first = (Code_t)chunk * CS_CHUNK_SIZE;
+        CodeSize_t range   = MIN(CS_CHUNK_SIZE, ctx->num_codes - chunk_first);
+        uint32_t count     = cs_get_chunk_count(match->solution_space, chunk);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        if (count == range)
+        {
+            mm_get_partition_range(ctx, guess, chunk_first, range, counts);
+        }
+        else
+        {
+            if (codes == NULL)
+            {
+                codes = malloc(CS_CHUNK_SIZE * sizeof(Code_t));
+            }
+            cs_get_chunk_codes(match->solution_space, chunk, codes);
+            mm_get_partition(ctx, guess, codes, count, counts);
+        }
+        for (Feedback_t fb = 0; fb < ctx->num_feedbacks; fb++)
+        {
+            out_counts[fb] += counts[fb];
+        }
+    }
+    free(codes);
+}
+
+static int compare_requests_by_guess(const void *a, const void *b)
+{
+    Code_t guess_a = (*(const MM_ConstrainRequest **)a)->guess;
+    Code_t guess_b = (*(const MM_ConstrainRequest **)b)->guess;
+    return (guess_a > guess_b) - (guess_a < guess_b);
+}
+
+static Feedback_t digits_fb(MM_Context *ctx, const PreparedGuess *guess, const uint8_t *digits)
+{
+    int num_b                     = 0;
+    int num_bw                    = 0;
+    int counts[MM_MAX_NUM_COLORS] = { 0 };
+    for (int j = 0; j < ctx->num_slots; j++)
+    {
+        int col = digits[j];
+        if (col == guess->colors[j])
+        {
+            num_b++;
+        }
+        if (counts[col] < guess->counts[col])
+        {
+            num_bw++;
+        }
+        counts[col]++;
+    }
+    return mm_feedback_to_code(ctx, num_b, num_bw - num_b);
+}
+
+// Decodes the slots of each code in the range once (odometer), they are shared by all requests of a chunk
+static void load_digits(MM_Context *ctx, Code_t first, CodeSize_t num_codes, uint8_t *out_digits)
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, first, colors);
+    for (CodeSize_t i = 0; i < num_codes; i++)
+    {
+        for (int j = 0; j < ctx->num_slots; j++)
+        {
+            out_digits[i * ctx->num_slots + j] = colors[j];
+        }
+        for (int j = 0; (j < ctx->num_slots) && (++colors[j] == ctx->num_colors); j++)
+        {
+            colors[j] = 0;
+        }
+    }
+}
+
+/*
+ * Summary: Applies a guess and its feedback to each of many matches of the same context in one sweep:
+ *     The code space is processed chunk by chunk, each chunk is decoded once and all solution spaces are filtered
+ *     while it is in cache. Requests with the same guess share one Gray walk over dense chunks.
+ *     Writes number of eliminated solutions into each request.
+ */
+void mm_constrain_batch(MM_Context *ctx, MM_ConstrainRequest *requests, int num_requests)
+{
+    MM_ConstrainRequest **swept = malloc(num_requests * sizeof(MM_ConstrainRequest *));
+    int num_swept               = 0;
+
+    for (int i = 0; i < num_requests; i++)
+    {
+        MM_Match *match = requests[i].match;
+
+        match->guesses[match->num_turns]   = requests[i].guess;
+        match->feedbacks[match->num_turns] = requests[i].feedback;
+        match->num_turns++;
+        requests[i].num_eliminated = 0;
+
+        if (match->symbolic_counting)
+        {
+            CodeSize_t remaining       = csp_count_consistent(match);
+            requests[i].num_eliminated = match->num_solutions - remaining;
+            match->num_solutions       = remaining;
+        }
+        else if (match->enable_recommendation)
+        {
+            swept[num_swept++] = &requests[i];
+        }
+    }
+
+    if (num_swept == 0)
+    {
+        free(swept);
+        return;
+    }
+    qsort(swept, num_swept, sizeof(MM_ConstrainRequest *), compare_requests_by_guess);
+
+    Code_t *codes          = malloc(CS_CHUNK_SIZE * sizeof(Code_t));
+    Feedback_t *feedbacks  = malloc(CS_CHUNK_SIZE * sizeof(Feedback_t));
+    Feedback_t *shared_fbs = malloc(CS_CHUNK_SIZE * sizeof(Feedback_t));
+    uint8_t *digits        = malloc((size_t)CS_CHUNK_SIZE * ctx->num_slots);
+    size_t num_chunks      = cs_get_num_chunks(swept[0]->match->solution_space);
+
+    for (size_t chunk = 0; chunk < num_chunks; chunk++)
+    {
+        Code_t chunk_first = (Code_t)chunk * CS_CHUNK_SIZE;
+        CodeSize_t range   = MIN(CS_CHUNK_SIZE, ctx->num_codes - chunk_first);
+        bool digits_loaded = false;
+
+        // Requests with the same guess form a group
+        for (int start = 0, end = 0; start < num_swept; start = end)
+        {
+            CodeSize_t group_count = 0;
+            for (end = start; (end < num_swept) && (swept[end]->guess == swept[start]->guess); end++)
+            {
+                group_count += cs_get_chunk_count(swept[end]->match->solution_space, chunk);
+            }
+            if (group_count == 0)
+            {
+                continue;
+            }
+
+            Code_t guess = swept[start]->guess;
+            PreparedGuess prepared;
+            prepare_guess(ctx, guess, &prepared);
+            bool use_shared = !ctx->fb_lookup_initialized && (2 * group_count >= range);
+            bool use_digits = !ctx->fb_lookup_initialized && !use_shared && (4 * group_count >= range)
+                           && !(ctx->rules & MM_RULES_NO_REPEAT);
+            if (use_shared)
+            {
+                mm_get_feedbacks_range(ctx, guess, chunk_first, range, shared_fbs);
+            }
+            if (use_digits && !digits_loaded)
+            {
+                load_digits(ctx, chunk_first, range, digits);
+                digits_loaded = true;
+            }
+
+            for (int i = start; i < end; i++)
+            {
+                CodeSet *space = swept[i]->match->solution_space;
+                if (cs_get_chunk_count(space, chunk) == 0)
+                {
+                    continue;
+                }
+
+                uint32_t num_codes = cs_get_chunk_codes(space, chunk, codes);
+                uint32_t num_kept  = 0;
+                if (use_shared)
+                {
+                    for (uint32_t j = 0; j < num_codes; j++)
+                    {
+                        feedbacks[j] = shared_fbs[codes[j] - chunk_first];
+                    }
+                }
+                else if (use_digits)
+                {
+                    for (uint32_t j = 0; j < num_codes; j++)
+                    {
+                        feedbacks[j] = digits_fb(ctx, &prepared, &digits[(codes[j] - chunk_first) * ctx->num_slots]);
+                    }
+                }
+                else
+                {
+                    mm_get_feedbacks(ctx, guess, codes, num_codes, feedbacks);
+                }
+
+                for (uint32_t j = 0; j < num_codes; j++)
+                {
+                    if (feedbacks[j] == swept[i]->feedback)
+                    {
+                        codes[num_kept++] = codes[j];
+                    }
+                }
+                if (num_kept != num_codes)
+                {
+                    cs_set_chunk_codes(space, chunk, codes, num_kept);
+                    swept[i]->num_eliminated += num_codes - num_kept;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < num_swept; i++)
+    {
+        swept[i]->match->num_solutions = cs_count(swept[i]->match->solution_space);
+    }
+
+    free(codes);
+    free(feedbacks);
+    free(shared_fbs);
+    free(digits);
+    free(swept);
 }
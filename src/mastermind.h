@@ -1,14 +1,27 @@
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "util/rng.h"
 
 #define MM_MAX_MAX_GUESSES   20
-#define MM_MAX_NUM_COLORS    8
-#define MM_MAX_NUM_SLOTS     6
-#define MM_MAX_NUM_FEEDBACKS 27 // (MAX_NUM_SLOTS * (MAX_NUM_SLOTS / 2.0 + 1.5))
+#define MM_MAX_NUM_COLORS    16
+#define MM_MAX_NUM_SLOTS     12
+#define MM_MAX_NUM_FEEDBACKS (MM_MAX_NUM_SLOTS * (MM_MAX_NUM_SLOTS + 3) / 2)
 
+// Code spaces larger than this are not enumerated, solvers that need no enumeration are used instead
+#define MM_MAX_ENUMERATED_CODES (1u << 27)
+// Pairwise feedback lookup table is only built up to this number of codes
+#define MM_MAX_LOOKUP_CODES 8192
+
+// Compile with -DMM_CODE_64 for code spaces with more than 2^32 codes, e.g. 10 colors and 10 slots
+#ifdef MM_CODE_64
+typedef uint64_t Code_t;
+typedef uint64_t CodeSize_t;
+#else
 typedef uint32_t Code_t;
 typedef uint32_t CodeSize_t;
+#endif
 typedef uint16_t Feedback_t;
 typedef uint16_t FeedbackSize_t;
 
@@ -19,28 +32,88 @@ typedef enum
     MM_MATCH_LOST
 } MM_MatchState;
 
+// Rule variants, can be combined
+typedef enum
+{
+    MM_RULES_CLASSIC    = 0,
+    MM_RULES_NO_REPEAT  = 1, // Codes don't repeat colors (as in Bulls and Cows), needs num_slots <= num_colors
+    MM_RULES_BLACK_ONLY = 2  // Feedback is only the number of blacks
+} MM_Rules;
+
 typedef struct MM_Context MM_Context;
 typedef struct MM_Match MM_Match;
 
+/*
+ * Walks the codes of an aligned block in reflected Gray order: Only one slot changes by one color per step,
+ * feedback against a fixed guess is updated in O(1) instead of being recalculated.
+ * Not for MM_RULES_NO_REPEAT, its codes are ranked permutations and not positional.
+ */
+typedef struct
+{
+    MM_Context *ctx;
+    int num_digits; // Number of low slots that are walked, higher slots stay fixed
+    Code_t code;
+    int colors[MM_MAX_NUM_SLOTS];
+    int directions[MM_MAX_NUM_SLOTS];
+    int focus[MM_MAX_NUM_SLOTS + 1];
+    Code_t place_values[MM_MAX_NUM_SLOTS];
+    int guess_colors[MM_MAX_NUM_SLOTS];
+    int guess_counts[MM_MAX_NUM_COLORS];
+    int code_counts[MM_MAX_NUM_COLORS];
+    int num_b;
+    int num_bw; // Blacks and whites
+} MM_GrayWalk;
+
+// Guess and feedback to be applied to a match by mm_constrain_batch
+typedef struct
+{
+    MM_Match *match;
+    Code_t guess;
+    Feedback_t feedback;
+    CodeSize_t num_eliminated; // Set by mm_constrain_batch
+} MM_ConstrainRequest;
+
+// Over all ordered pairs of codes: Number of pairs yielding each feedback and number of codes that yield it at least once
+typedef struct
+{
+    uint64_t num_pairs[MM_MAX_NUM_FEEDBACKS];
+    CodeSize_t num_hits[MM_MAX_NUM_FEEDBACKS];
+} MM_FeedbackStats;
+
 MM_Context *mm_new_ctx(int max_guesses, int num_slots, int num_colors);
+MM_Context *mm_new_ctx_rules(int max_guesses, int num_slots, int num_colors, int rules);
 void mm_free_ctx(MM_Context *ctx);
 Feedback_t mm_get_feedback(MM_Context *ctx, Code_t a, Code_t b);
 void mm_code_to_feedback(MM_Context *ctx, Feedback_t fb_code, int *b, int *w);
 Feedback_t mm_feedback_to_code(MM_Context *ctx, int b, int w);
 bool mm_is_winning_feedback(MM_Context *ctx, Feedback_t fb);
-int mm_get_color_at_pos(int num_colors, Code_t code, int index);
+int mm_get_color_at_pos(MM_Context *ctx, Code_t code, int index);
+bool mm_is_valid_colors(MM_Context *ctx, const int *colors);
 Code_t mm_colors_to_code(MM_Context *ctx, int *colors);
+void mm_code_to_colors(MM_Context *ctx, Code_t code, int *out_colors);
 
 int mm_get_max_guesses(MM_Context *ctx);
 CodeSize_t mm_get_num_codes(MM_Context *ctx);
 int mm_get_num_colors(MM_Context *ctx);
 int mm_get_num_slots(MM_Context *ctx);
 int mm_get_num_feedbacks(MM_Context *ctx);
+int mm_get_rules(MM_Context *ctx);
+bool mm_is_enumerable(MM_Context *ctx);
+void mm_seed(MM_Context *ctx, uint64_t seed);
+uint64_t mm_get_seed(MM_Context *ctx);
+Rng *mm_get_rng(MM_Context *ctx);
+Code_t mm_draw_code(MM_Context *ctx, Rng *rng);
+Code_t mm_get_random_code(MM_Context *ctx);
 
 MM_Match *mm_new_match(MM_Context *ctx, bool enable_sol_counting);
+MM_Match *mm_copy_match(const MM_Match *match);
 void mm_free_match(MM_Match *match);
+void mm_seed_match(MM_Match *match, uint64_t seed);
+Rng *mm_get_match_rng(MM_Match *match);
 CodeSize_t mm_constrain(MM_Match *match, Code_t input, Feedback_t feedback);
+void mm_constrain_batch(MM_Context *ctx, MM_ConstrainRequest *requests, int num_requests);
 MM_Context *mm_get_context(MM_Match *match);
+size_t mm_get_match_memory(const MM_Match *match);
 
 CodeSize_t mm_get_remaining_solutions(const MM_Match *match);
 int mm_get_turns(const MM_Match *match);
@@ -49,5 +122,18 @@ Code_t mm_get_history_guess(const MM_Match *match, int index);
 MM_MatchState mm_get_state(const MM_Match *match);
 bool mm_is_solution_counting_enabled(const MM_Match *match);
 bool mm_is_in_solution(const MM_Match *match, Code_t code);
+CodeSize_t mm_get_solutions(const MM_Match *match, Code_t *out_codes);
+CodeSize_t mm_sample_solutions(const MM_Match *match, Rng *rng, CodeSize_t max_samples, Code_t *out_sample);
+
+void mm_get_feedbacks(MM_Context *ctx, Code_t guess, const Code_t *codes, CodeSize_t num_codes, Feedback_t *out_feedbacks);
+void mm_get_partition(MM_Context *ctx, Code_t guess, const Code_t *codes, CodeSize_t num_codes, CodeSize_t *out_counts);
+
+void mm_gray_begin(MM_Context *ctx, Code_t guess, Code_t first, int num_digits, MM_GrayWalk *out_walk);
+bool mm_gray_next(MM_GrayWalk *walk);
+Feedback_t mm_gray_get_feedback(const MM_GrayWalk *walk);
+void mm_get_feedbacks_range(MM_Context *ctx, Code_t guess, Code_t first, CodeSize_t num_codes, Feedback_t *out_feedbacks);
+void mm_get_partition_range(MM_Context *ctx, Code_t guess, Code_t first, CodeSize_t num_codes, CodeSize_t *out_counts);
+void mm_get_solution_partition(MM_Match *match, Code_t guess, CodeSize_t *out_counts);
 
-void mm_init_feedback_lookup(MM_Context *ctx);
+bool mm_init_feedback_lookup(MM_Context *ctx);
+const MM_FeedbackStats *mm_get_feedback_stats(MM_Context *ctx);
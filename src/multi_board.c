@@ -0,0 +1,249 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "multi_board.h"
+#include "recommend.h"
+#include "util/console.h"
+#include "util/timer.h"
+
+/*
+ * Each board is an ordinary match, all boards receive the same guess. Constraining goes through
+ * mm_constrain_batch, which groups requests by guess: The code space is swept once per guess and
+ * the solution spaces of all boards are filtered together.
+ */
+
+#define EPSILON   1e-9
+#define BUDGET_MS 1000 // For the recommendation shown in the game
+
+struct MultiMatch
+{
+    MM_Context *ctx;
+    int num_boards;
+    int num_turns;
+    MM_Match *boards[MB_MAX_BOARDS];
+};
+
+// Returns NULL if the code space can't be enumerated or num_boards is out of range
+MultiMatch *mb_new_match(MM_Context *ctx, int num_boards)
+{
+    if (!mm_is_enumerable(ctx) || (num_boards < 1) || (num_boards > MB_MAX_BOARDS))
+    {
+        return NULL;
+    }
+    MultiMatch *result = malloc(sizeof(MultiMatch));
+    *result            = (MultiMatch){ .ctx = ctx, .num_boards = num_boards };
+    for (int i = 0; i < num_boards; i++)
+    {
+        result->boards[i] = mm_new_match(ctx, true);
+    }
+    return result;
+}
+
+void mb_free_match(MultiMatch *match)
+{
+    for (int i = 0; i < match->num_boards; i++)
+    {
+        mm_free_match(match->boards[i]);
+    }
+    free(match);
+}
+
+// Applies guess with the feedback of each board, boards that are done ignore it
+void mb_constrain(MultiMatch *match, Code_t guess, const Feedback_t *feedbacks)
+{
+    MM_ConstrainRequest requests[MB_MAX_BOARDS];
+    int num_requests = 0;
+    for (int i = 0; i < match->num_boards; i++)
+    {
+        if (mm_get_state(match->boards[i]) == MM_MATCH_PENDING)
+        {
+            requests[num_requests++] = (MM_ConstrainRequest){ .match    = match->boards[i],
+                                                              .guess    = guess,
+                                                              .feedback = feedbacks[i] };
+        }
+    }
+    if (num_requests > 0)
+    {
+        mm_constrain_batch(match->ctx, requests, num_requests);
+    }
+    match->num_turns++;
+}
+
+MM_Context *mb_get_context(MultiMatch *match)
+{
+    return match->ctx;
+}
+
+int mb_get_num_boards(const MultiMatch *match)
+{
+    return match->num_boards;
+}
+
+MM_Match *mb_get_board(MultiMatch *match, int index)
+{
+    return match->boards[index];
+}
+
+int mb_get_turns(const MultiMatch *match)
+{
+    return match->num_turns;
+}
+
+// Won if all boards are won, lost as soon as any board is lost
+MM_MatchState mb_get_state(const MultiMatch *match)
+{
+    MM_MatchState result = MM_MATCH_WON;
+    for (int i = 0; i < match->num_boards; i++)
+    {
+        MM_MatchState state = mm_get_state(match->boards[i]);
+        if (state == MM_MATCH_LOST)
+        {
+            return MM_MATCH_LOST;
+        }
+        if (state == MM_MATCH_PENDING)
+        {
+            result = MM_MATCH_PENDING;
+        }
+    }
+    return result;
+}
+
+/*
+ * Summary: Guess with the most information about all boards. Secrets are independent, so the entropy of the joint
+ *     partition (the vector of feedbacks) is the sum of the entropies of the partitions of each board.
+ *     A board with a single solution left is solved right away. Candidates are the symmetry representatives
+ *     of the board with most solutions, all boards share the history, so they are representatives for every board.
+ */
+Code_t mb_recommend(MultiMatch *match, int budget_ms)
+{
+    MM_Match *widest = NULL;
+    for (int i = 0; i < match->num_boards; i++)
+    {
+        MM_Match *board = match->boards[i];
+        if (mm_get_state(board) != MM_MATCH_PENDING)
+        {
+            continue;
+        }
+        if (mm_get_remaining_solutions(board) == 1)
+        {
+            Code_t solution;
+            mm_get_solutions(board, &solution);
+            return solution;
+        }
+        if ((widest == NULL) || (mm_get_remaining_solutions(board) > mm_get_remaining_solutions(widest)))
+        {
+            widest = board;
+        }
+    }
+    if (widest == NULL)
+    {
+        return 0;
+    }
+
+    uint64_t deadline = timer_deadline_us(budget_ms);
+    Code_t *candidates;
+    CodeSize_t num_candidates = rec_get_candidates(widest, deadline, &candidates, NULL);
+    if (num_candidates == 0)
+    {
+        return 0;
+    }
+    Code_t result        = candidates[0];
+    double best_score    = INFINITY;
+    bool best_consistent = false;
+    for (CodeSize_t i = 0; (i < num_candidates) && ((i == 0) || !timer_expired(deadline)); i++)
+    {
+        double score    = 0;
+        bool consistent = false;
+        for (int j = 0; j < match->num_boards; j++)
+        {
+            MM_Match *board = match->boards[j];
+            if (mm_get_state(board) != MM_MATCH_PENDING)
+            {
+                continue;
+            }
+            CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+            mm_get_solution_partition(board, candidates[i], counts);
+            score      += rec_score_partition(REC_ENTROPY, mm_get_remaining_solutions(board), mm_get_num_feedbacks(match->ctx), counts);
+            consistent |= mm_is_in_solution(board, candidates[i]);
+        }
+        if ((score < best_score - EPSILON) || ((score < best_score + EPSILON) && consistent && !best_consistent))
+        {
+            result          = candidates[i];
+            best_score      = score;
+            best_consistent = consistent;
+        }
+    }
+    free(candidates);
+    return result;
+}
+
+void multi_board(MM_Context *ctx)
+{
+    int num_boards, show_recommendation;
+    if (!mm_is_enumerable(ctx))
+    {
+        printf("Too many codes for multiple boards, choose fewer slots or colors.\n");
+        return;
+    }
+    if (!readline_int("Number of boards", 4, 2, MB_MAX_BOARDS, &num_boards)
+        || !readline_int("Show recommended guess", 0, 0, 1, &show_recommendation))
+    {
+        return;
+    }
+
+    // One more guess per additional board
+    int max_guesses      = mm_get_max_guesses(ctx) + num_boards - 1;
+    max_guesses          = (max_guesses > MM_MAX_MAX_GUESSES) ? MM_MAX_MAX_GUESSES : max_guesses;
+    MM_Context *game_ctx = mm_new_ctx_rules(max_guesses, mm_get_num_slots(ctx), mm_get_num_colors(ctx), mm_get_rules(ctx));
+    MultiMatch *match    = mb_new_match(game_ctx, num_boards);
+    Code_t secrets[MB_MAX_BOARDS];
+    for (int i = 0; i < num_boards; i++)
+    {
+        secrets[i] = mm_draw_code(game_ctx, mm_get_rng(ctx)); // Continues the stream of the session
+    }
+
+    printf("%d guesses for %d boards.\n", max_guesses, num_boards);
+    while (mb_get_state(match) == MM_MATCH_PENDING)
+    {
+        if (show_recommendation)
+        {
+            printf("Recommended:");
+            print_colors(game_ctx, mb_recommend(match, BUDGET_MS));
+            printf("\n");
+        }
+
+        Code_t input;
+        if (!read_colors(game_ctx, mb_get_turns(match) + 1, &input))
+        {
+            printf("Aborted.\n");
+            break;
+        }
+
+        Feedback_t feedbacks[MB_MAX_BOARDS];
+        bool pending[MB_MAX_BOARDS];
+        for (int i = 0; i < num_boards; i++)
+        {
+            feedbacks[i] = mm_get_feedback(game_ctx, input, secrets[i]);
+            pending[i]   = (mm_get_state(mb_get_board(match, i)) == MM_MATCH_PENDING);
+        }
+        mb_constrain(match, input, feedbacks);
+        for (int i = 0; i < num_boards; i++)
+        {
+            if (pending[i])
+            {
+                printf("%d:", i + 1);
+                print_guess(-1, mb_get_board(match, i), true);
+                printf("\n");
+            }
+        }
+    }
+
+    for (int i = 0; i < num_boards; i++)
+    {
+        printf("Board %d: ", i + 1);
+        print_match_end_message(mb_get_board(match, i), secrets[i], true);
+    }
+    mb_free_match(match);
+    mm_free_ctx(game_ctx);
+}
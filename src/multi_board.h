@@ -0,0 +1,22 @@
+#pragma once
+#include <stdbool.h>
+#include "mastermind.h"
+
+#define MB_MAX_BOARDS 8
+
+/*
+ * Several secrets are played at once (as in Quordle): Every guess is scored against all boards,
+ * each board has its own feedback and solution space. A board is done once its secret was guessed.
+ */
+typedef struct MultiMatch MultiMatch;
+
+MultiMatch *mb_new_match(MM_Context *ctx, int num_boards);
+void mb_free_match(MultiMatch *match);
+void mb_constrain(MultiMatch *match, Code_t guess, const Feedback_t *feedbacks);
+MM_Context *mb_get_context(MultiMatch *match);
+int mb_get_num_boards(const MultiMatch *match);
+MM_Match *mb_get_board(MultiMatch *match, int index);
+int mb_get_turns(const MultiMatch *match);
+MM_MatchState mb_get_state(const MultiMatch *match);
+Code_t mb_recommend(MultiMatch *match, int budget_ms);
+void multi_board(MM_Context *ctx);
@@ -50,8 +50,8 @@ static const Transition allowed_recv_transitions[] = {
 
 static const int num_allowed_recv_transitions = sizeof(allowed_recv_transitions) / sizeof(Transition);
 
-bool sigint;
-bool sigpipe;
+static volatile sig_atomic_t sigint;
+static volatile sig_atomic_t sigpipe;
 
 static void log_transition(PlayerState from, PlayerState to)
 {
@@ -224,14 +224,16 @@ static void handle_transition(ClientData *data)
         RulesPackage_R rules;
         receive(data->socket, &rules, sizeof(RulesPackage_R));
         printf("~ ~ Server rules ~ ~\n"
-               "%d players, %d colors, %d slots, %d max. guesses, %d rounds\n",
+               "%d players, %d colors, %d slots, %d max. guesses, %d rounds%s%s\n",
                rules.num_players,
                rules.num_colors,
                rules.num_slots,
                rules.max_guesses,
-               rules.num_rounds);
+               rules.num_rounds,
+               (rules.rules & MM_RULES_NO_REPEAT) ? ", no repeated colors" : "",
+               (rules.rules & MM_RULES_BLACK_ONLY) ? ", blacks only" : "");
         data->rules = rules;
-        data->ctx   = mm_new_ctx(rules.max_guesses, rules.num_slots, rules.num_colors);
+        data->ctx   = mm_new_ctx_rules(rules.max_guesses, rules.num_slots, rules.num_colors, rules.rules);
     }
     else if (data->state == PLAYER_STATE_CHOOSING_NAME)
     {
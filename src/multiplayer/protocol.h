@@ -43,6 +43,7 @@ typedef struct
     int num_slots;
     int num_players;
     int num_colors;
+    int rules; // MM_Rules
     bool show_asterisk;
 } RulesPackage_R;
 
@@ -38,6 +38,7 @@ typedef struct
     int curr_round;
     Player players[MAX_NUM_PLAYERS];
     MM_Context *ctx;
+    Rng rng; // Draws the solutions of this session only
     Code_t curr_solution;
     time_t curr_start;
 } ServerData;
@@ -307,6 +308,7 @@ static void handle_transition(ServerData *data, int pl)
             .max_guesses   = mm_get_max_guesses(data->ctx),
             .num_colors    = mm_get_num_colors(data->ctx),
             .num_slots     = mm_get_num_slots(data->ctx),
+            .rules         = mm_get_rules(data->ctx),
             .show_asterisk = false
         };
         send_transition(player, PLAYER_STATE_RULES_RECEIVED);
@@ -356,7 +358,7 @@ static void handle_transition(ServerData *data, int pl)
             {
                 data->players[i].match = mm_new_match(data->ctx, false);
             }
-            data->curr_solution = rand() % mm_get_num_codes(data->ctx);
+            data->curr_solution = mm_draw_code(data->ctx, &data->rng);
             send_transition_broadcast(data, PLAYER_STATE_GUESSING);
             if (data->curr_round == 0)
             {
@@ -524,6 +526,7 @@ void start_server(MM_Context *ctx, int num_players, int num_rounds, int port)
         snprintf(data.players[i].name, MAX_PLAYER_NAME_BYTES - 1, "Player %d", i);
     }
 
+    rng_seed(&data.rng, rng_next(mm_get_rng(ctx))); // Solutions of all rounds follow from the context's seed
     open_listening_socket(&data);
     if (data.listening_socket < 0)
     {
@@ -0,0 +1,198 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "puzzle_pool.h"
+
+typedef enum
+{
+    POOL_PREPARING,
+    POOL_RUNNING,
+    POOL_FAILED // Configuration too large for puzzles
+} PoolState;
+
+// Head is only written by the consumer, tail only by the producer
+typedef struct
+{
+    QkPuzzle slots[PP_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+} PuzzleQueue;
+
+struct PuzzlePool
+{
+    MM_Context *ctx; // Private copy of the configuration
+    uint64_t seed;
+    pthread_t thread;
+    int state; // PoolState
+    int stop;
+    PuzzleQueue queues[QK_NUM_DIFFICULTIES];
+
+    // Puzzles don't pass through the lock, it only guards sleeping: The worker waits while all queues are full,
+    // the consumer while the pool prepares or its queue is empty. Each side broadcasts after its change.
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+static void notify(PuzzlePool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static bool is_stopped(PuzzlePool *pool)
+{
+    return __atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE);
+}
+
+static bool queue_is_full(PuzzleQueue *queue)
+{
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    return queue->tail - head == PP_QUEUE_SIZE;
+}
+
+// Producer side, the slot is written before the tail is published
+static void queue_push(PuzzleQueue *queue, const QkPuzzle *puzzle)
+{
+    uint32_t tail                            = queue->tail;
+    queue->slots[tail & (PP_QUEUE_SIZE - 1)] = *puzzle;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Consumer side, returns false if the queue is empty
+static bool queue_pop(PuzzleQueue *queue, QkPuzzle *out_puzzle)
+{
+    uint32_t head = queue->head;
+    if (__atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == head)
+    {
+        return false;
+    }
+    *out_puzzle = queue->slots[head & (PP_QUEUE_SIZE - 1)];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool all_full(PuzzlePool *pool)
+{
+    for (int i = 0; i < QK_NUM_DIFFICULTIES; i++)
+    {
+        if (!queue_is_full(&pool->queues[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prepares the private context, then keeps every queue filled and sleeps until a puzzle is taken
+static void *run_worker(void *arg)
+{
+    PuzzlePool *pool = arg;
+    Quickie *quickie = qk_new(pool->ctx, pool->seed);
+    __atomic_store_n(&pool->state, (quickie != NULL) ? POOL_RUNNING : POOL_FAILED, __ATOMIC_RELEASE);
+    notify(pool);
+    if (quickie == NULL)
+    {
+        return NULL;
+    }
+    qk_set_cancel_flag(quickie, &pool->stop);
+
+    while (!is_stopped(pool))
+    {
+        for (int i = 0; (i < QK_NUM_DIFFICULTIES) && !is_stopped(pool); i++)
+        {
+            QkPuzzle puzzle;
+            if (!queue_is_full(&pool->queues[i]) && qk_generate(quickie, i + 1, &puzzle))
+            {
+                queue_push(&pool->queues[i], &puzzle);
+                notify(pool);
+            }
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (!is_stopped(pool) && all_full(pool))
+        {
+            pthread_cond_wait(&pool->changed, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    qk_free(quickie);
+    return NULL;
+}
+
+// Starts the worker for the configuration of ctx, returns NULL if the code space can't be enumerated
+PuzzlePool *pp_start(MM_Context *ctx, uint64_t seed)
+{
+    if (!mm_is_enumerable(ctx))
+    {
+        return NULL;
+    }
+    PuzzlePool *result = calloc(1, sizeof(PuzzlePool));
+    result->ctx        = mm_new_ctx_rules(mm_get_max_guesses(ctx), mm_get_num_slots(ctx), mm_get_num_colors(ctx), mm_get_rules(ctx));
+    result->seed       = seed;
+    pthread_mutex_init(&result->lock, NULL);
+    pthread_cond_init(&result->changed, NULL);
+    if (pthread_create(&result->thread, NULL, run_worker, result) != 0)
+    {
+        pthread_mutex_destroy(&result->lock);
+        pthread_cond_destroy(&result->changed);
+        mm_free_ctx(result->ctx);
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+// Stops the worker within one turn of the puzzle it is generating, NULL is ignored
+void pp_stop(PuzzlePool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    notify(pool);
+    pthread_join(pool->thread, NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->changed);
+    mm_free_ctx(pool->ctx);
+    free(pool);
+}
+
+/*
+ * Summary: Waits until the worker has prepared its context
+ * Returns: false if the configuration is too large for puzzles
+ */
+bool pp_is_available(PuzzlePool *pool)
+{
+    int state;
+    pthread_mutex_lock(&pool->lock);
+    while ((state = __atomic_load_n(&pool->state, __ATOMIC_ACQUIRE)) == POOL_PREPARING)
+    {
+        pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return state == POOL_RUNNING;
+}
+
+/*
+ * Summary: Takes a puzzle of difficulty (1: easy to QK_NUM_DIFFICULTIES: hard), waits if none is ready yet.
+ *     Only one thread may take puzzles.
+ * Returns: false if the pool can't generate puzzles
+ */
+bool pp_take(PuzzlePool *pool, int difficulty, QkPuzzle *out_puzzle)
+{
+    if (!pp_is_available(pool))
+    {
+        return false;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (!queue_pop(&pool->queues[difficulty - 1], out_puzzle))
+    {
+        pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    notify(pool); // A slot is free again
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdbool.h>
+#include "mastermind.h"
+#include "quickie.h"
+
+#define PP_QUEUE_SIZE 8 // Puzzles kept ready per difficulty, power of two
+
+/*
+ * Pregenerates fast mode puzzles on a worker thread while the player is elsewhere. The worker has its own
+ * context of the same configuration, so the caller's context is never touched. Each difficulty has a
+ * bounded single-producer single-consumer queue without locks, a condition variable only wakes a side that sleeps.
+ */
+typedef struct PuzzlePool PuzzlePool;
+
+PuzzlePool *pp_start(MM_Context *ctx, uint64_t seed);
+void pp_stop(PuzzlePool *pool);
+bool pp_is_available(PuzzlePool *pool);
+bool pp_take(PuzzlePool *pool, int difficulty, QkPuzzle *out_puzzle);
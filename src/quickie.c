@@ -1,255 +1,315 @@
+#define _DEFAULT_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <inttypes.h>
 
 #include "quickie.h"
 #include "mastermind.h"
+#include "puzzle_pool.h"
+#include "recommend.h"
 #include "util/console.h"
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
-// Mapping from feedback to rank
-double fb_scores[MM_MAX_NUM_FEEDBACKS] = {
-    5, 0, 2, 7, 12, 3, 1, 6, 11, 4, 8, 10, 9, 13
-};
-int num_fbs         = 14;
-bool fb_scores_init = true;
-
-#define NUM_DIFFICULTIES 3
-static const char *difficulty_labels[NUM_DIFFICULTIES] = { "Easy", "Medium", "Hard" };
+static const char *difficulty_labels[QK_NUM_DIFFICULTIES] = { "Easy", "Medium", "Hard" };
 
-void calculate_fb_scores(MM_Context *ctx)
+struct Quickie
 {
-    FeedbackSize_t num_feedbacks = mm_get_num_feedbacks(ctx);
-    CodeSize_t num_codes         = mm_get_num_codes(ctx);
+    MM_Context *ctx;
+    Rng rng;
+    int num_fbs;       // Reachable feedbacks
+    const int *cancel; // Set by another thread to abort qk_generate, NULL: Never
+    int fb_ranks[MM_MAX_NUM_FEEDBACKS];
+
+    // Scratch buffers with one entry per code
+    Code_t *candidates;
+    Code_t *solutions;
+    Code_t *bucketed;
+    Feedback_t *feedbacks;
+    CodeSize_t *aggregations;
+};
 
-    num_fbs = 0;
-    for (Feedback_t fb = 0; fb < num_feedbacks; fb++)
+/*
+ * Summary: Ranks feedbacks by difficulty, rank 0 for the feedback with most solutions per guess that yields it.
+ *     Unreachable feedbacks rank last, ties go to the lower feedback.
+ * Returns: Number of reachable feedbacks
+ */
+static int rank_feedbacks(MM_Context *ctx, int *out_ranks)
+{
+    const MM_FeedbackStats *stats = mm_get_feedback_stats(ctx);
+    int num_feedbacks             = mm_get_num_feedbacks(ctx);
+    double scores[MM_MAX_NUM_FEEDBACKS];
+    int result = 0;
+    for (int fb = 0; fb < num_feedbacks; fb++)
     {
-        fb_scores[fb] = 0;
-        int hits      = 0;
-        for (Code_t i = 0; i < num_codes; i++)
-        {
-            bool hit = false;
-            for (Code_t j = 0; j < num_codes; j++)
-            {
-                if (mm_get_feedback(ctx, i, j) == fb)
-                {
-                    hit = true;
-                    fb_scores[fb]++;
-                }
-            }
-            if (hit)
-            {
-                hits++;
-            }
-        }
-        if (hits != 0)
-        {
-            fb_scores[fb] = (double)fb_scores[fb] / hits;
-            num_fbs++;
-        }
+        scores[fb] = (stats->num_hits[fb] != 0) ? (double)stats->num_pairs[fb] / stats->num_hits[fb] : 0;
+        result    += (stats->num_hits[fb] != 0);
     }
-
-#ifdef DEBUG
-    printf("num codes: %d, ", num_codes);
-    printf("num_fbs / reachable: %d / %d\n", mm_get_num_feedbacks(ctx), num_fbs);
-#endif
-
-    Feedback_t sorted[MM_MAX_NUM_FEEDBACKS];
-    for (int i = 0; i < num_feedbacks; i++)
+    for (int fb = 0; fb < num_feedbacks; fb++)
     {
-        int max = -1;
-        for (int j = 0; j < num_feedbacks; j++)
+        out_ranks[fb] = 0;
+        for (int other = 0; other < num_feedbacks; other++)
         {
-            bool f = false;
-            for (int k = 0; k < i; k++)
-            {
-                if (sorted[k] == j)
-                {
-                    f = true;
-                    break;
-                }
-            }
-            if (f)
-            {
-                continue;
-            }
-            if ((fb_scores[j] > fb_scores[max]) || (max == -1))
-            {
-                max = j;
-            }
+            out_ranks[fb] += (scores[other] > scores[fb]) || ((scores[other] == scores[fb]) && (other < fb));
         }
-        sorted[i] = max;
+    }
+
 #ifdef DEBUG
-        print_feedback(ctx, sorted[i]);
-        printf("score: %f, %d\n", fb_scores[sorted[i]], i);
+    printf("num codes: %" PRIu64 ", ", (uint64_t)mm_get_num_codes(ctx));
+    printf("num_fbs / reachable: %d / %d\n", num_feedbacks, result);
 #endif
-        fb_scores[sorted[i]] = i;
-    }
+    return result;
 }
 
-static CodeSize_t recommend_guess(MM_Match *match, Code_t **candidates)
+// Minimax candidates into out_candidates (one entry per code), solutions and aggregations are scratch buffers of the same size
+static CodeSize_t recommend_guess(MM_Match *match, Code_t *solutions, CodeSize_t *aggregations, Code_t *out_candidates)
 {
-    MM_Context *ctx      = mm_get_context(match);
-    CodeSize_t num_codes = mm_get_num_codes(ctx);
-    long *aggregations   = malloc(num_codes * sizeof(long));
+    MM_Context *ctx          = mm_get_context(match);
+    CodeSize_t num_codes     = mm_get_num_codes(ctx);
+    CodeSize_t num_solutions = mm_get_solutions(match, solutions);
 
-    if (mm_get_remaining_solutions(match) == 1)
+    if (num_solutions == 1)
     {
-        for (Code_t j = 0; j < num_codes; j++)
-        {
-            if (mm_is_in_solution(match, j))
-            {
-                *candidates      = malloc(sizeof(Code_t) * 1);
-                (*candidates)[0] = j;
-                return 1;
-            }
-        }
+        out_candidates[0] = solutions[0];
+        return 1;
     }
 
     for (Code_t i = 0; i < num_codes; i++)
     {
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        if (num_solutions == num_codes)
+        {
+            mm_get_partition_range(ctx, i, 0, num_codes, counts);
+        }
+        else
+        {
+            mm_get_partition(ctx, i, solutions, num_solutions, counts);
+        }
         aggregations[i] = 0;
         for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
         {
-            CodeSize_t num_solutions = 0;
-            for (Code_t j = 0; j < num_codes; j++)
-            {
-                if (mm_is_in_solution(match, j))
-                {
-                    if (mm_get_feedback(ctx, j, i) == fb)
-                    {
-                        num_solutions++;
-                    }
-                }
-            }
-            aggregations[i] = MAX(aggregations[i], num_solutions);
+            aggregations[i] = MAX(aggregations[i], counts[fb]);
         }
     }
 
-    int min            = INT32_MAX;
-    int num_candidates = 0;
+    CodeSize_t min = (CodeSize_t)-1;
     for (Code_t i = 0; i < num_codes; i++)
     {
-        if (aggregations[i] < min)
-        {
-            min            = aggregations[i];
-            num_candidates = 0;
-        }
-        if (aggregations[i] == min)
-        {
-            num_candidates++;
-        }
+        min = (aggregations[i] < min) ? aggregations[i] : min;
     }
 
-    *candidates = malloc(sizeof(Code_t) * num_candidates);
-    int counter = 0;
+    CodeSize_t num_candidates = 0;
     for (Code_t i = 0; i < num_codes; i++)
     {
         if (aggregations[i] == min)
         {
-            (*candidates)[counter++] = i;
+            out_candidates[num_candidates++] = i;
         }
     }
-
-    free(aggregations);
     return num_candidates;
 }
 
-static Code_t get_guess_and_solution(MM_Match *match, CodeSize_t num_candidates, Code_t *candidates, int min_score, int max_score, Code_t *solution)
+// Remaining solutions grouped by their feedback against a guess, bucket fb is solutions[offsets[fb]] to solutions[offsets[fb + 1] - 1]
+typedef struct
+{
+    CodeSize_t offsets[MM_MAX_NUM_FEEDBACKS + 1];
+    Code_t *solutions;
+} FeedbackBuckets;
+
+// Counting sort of the solutions by feedback, feedbacks come from one pass of the batched kernel
+static void build_buckets(MM_Context *ctx, Code_t guess, const Code_t *solutions, CodeSize_t num_solutions, Feedback_t *feedbacks, FeedbackBuckets *out_buckets)
+{
+    int num_feedbacks = mm_get_num_feedbacks(ctx);
+    mm_get_feedbacks(ctx, guess, solutions, num_solutions, feedbacks);
+    memset(out_buckets->offsets, 0, sizeof(out_buckets->offsets));
+    for (CodeSize_t i = 0; i < num_solutions; i++)
+    {
+        out_buckets->offsets[feedbacks[i] + 1]++;
+    }
+    for (int fb = 0; fb < num_feedbacks; fb++)
+    {
+        out_buckets->offsets[fb + 1] += out_buckets->offsets[fb];
+    }
+
+    CodeSize_t next[MM_MAX_NUM_FEEDBACKS];
+    memcpy(next, out_buckets->offsets, num_feedbacks * sizeof(CodeSize_t));
+    for (CodeSize_t i = 0; i < num_solutions; i++)
+    {
+        out_buckets->solutions[next[feedbacks[i]]++] = solutions[i];
+    }
+}
+
+/*
+ * Summary: Random candidate guess with a random solution whose feedback rank is in [min_score, max_score).
+ *     Solutions of each candidate are bucketed by feedback, so the number of viable solutions is a sum over
+ *     bucket sizes and the solution is picked with one random draw.
+ */
+static Code_t get_guess_and_solution(Quickie *quickie, MM_Match *match, CodeSize_t num_candidates, int min_score, int max_score, Code_t *solution)
 {
+    Code_t *candidates  = quickie->candidates;
+    const int *fb_ranks = quickie->fb_ranks;
     if (mm_get_remaining_solutions(match) == 1)
     {
         return candidates[0];
     }
 
-    // Shuffle candidates
+    // Shuffle candidates (Fisher-Yates)
     for (CodeSize_t i = 0; i < num_candidates; i++)
     {
-        int j         = rand() % num_candidates;
+        CodeSize_t j  = i + rng_below(&quickie->rng, num_candidates - i);
         Code_t temp   = candidates[i];
         candidates[i] = candidates[j];
         candidates[j] = temp;
     }
 
-    MM_Context *ctx = mm_get_context(match);
+    MM_Context *ctx          = quickie->ctx;
+    Code_t *solutions        = quickie->solutions;
+    CodeSize_t num_solutions = mm_get_solutions(match, solutions);
+    FeedbackBuckets buckets  = { .solutions = quickie->bucketed };
+    Code_t result            = candidates[0];
+    bool found               = false;
+    *solution                = solutions[num_solutions - 1];
 
-    for (CodeSize_t i = 0; i < num_candidates; i++)
+    for (CodeSize_t i = 0; (i < num_candidates) && !found; i++)
     {
-        Code_t candidate = candidates[i];
-        int viable       = 0;
-        for (Code_t j = 0; j < mm_get_num_codes(ctx); j++)
+        build_buckets(ctx, candidates[i], solutions, num_solutions, quickie->feedbacks, &buckets);
+        CodeSize_t viable = 0;
+        for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
         {
-            int score = fb_scores[mm_get_feedback(ctx, candidate, j)];
-            if (mm_is_in_solution(match, j) && (score < max_score && score >= min_score))
+            if ((fb_ranks[fb] >= min_score) && (fb_ranks[fb] < max_score))
             {
-                viable++;
+                viable += buckets.offsets[fb + 1] - buckets.offsets[fb];
             }
         }
+        if (viable == 0)
+        {
+#ifdef DEBUG
+            printf("Skipping code...\n");
+#endif
+            continue;
+        }
 
-        if (viable != 0)
+        CodeSize_t index = rng_below(&quickie->rng, viable);
+        for (Feedback_t fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
         {
-            int sol = rand() % viable;
-            for (Code_t j = 0; j < mm_get_num_codes(ctx); j++)
+            CodeSize_t size = buckets.offsets[fb + 1] - buckets.offsets[fb];
+            if ((fb_ranks[fb] < min_score) || (fb_ranks[fb] >= max_score))
+            {
+                continue;
+            }
+            if (index < size)
             {
-                int score = fb_scores[mm_get_feedback(ctx, candidate, j)];
-                if (mm_is_in_solution(match, j) && (score < max_score && score >= min_score))
-                {
-                    if (sol == 0)
-                    {
-                        *solution = j;
-                        return candidate;
-                    }
-                    else
-                    {
-                        sol--;
-                    }
-                }
+                *solution = buckets.solutions[buckets.offsets[fb] + index];
+                break;
             }
+            index -= size;
         }
-#ifdef DEBUG
-        printf("Skipping code...\n");
-#endif
+        result = candidates[i];
+        found  = true;
     }
 
 #ifdef DEBUG
-    printf("Ran out of guess/solution-pairs\n");
+    if (!found)
+    {
+        printf("Ran out of guess/solution-pairs\n");
+    }
 #endif
+    return result;
+}
 
-    for (Code_t code = 0; code < mm_get_num_codes(ctx); code++)
+// Minimax guess as in Knuth's algorithm: Smallest worst case over all codes, consistent codes are preferred
+Code_t quickie_get_guess(MM_Match *match)
+{
+    CodeSize_t num_codes      = mm_get_num_codes(mm_get_context(match));
+    Code_t *candidates        = malloc(num_codes * sizeof(Code_t));
+    Code_t *solutions         = malloc(num_codes * sizeof(Code_t));
+    CodeSize_t *aggregations  = malloc(num_codes * sizeof(CodeSize_t));
+    CodeSize_t num_candidates = recommend_guess(match, solutions, aggregations, candidates);
+    Code_t result             = candidates[0];
+    for (CodeSize_t i = 0; i < num_candidates; i++)
     {
-        if (mm_is_in_solution(match, code))
+        if (mm_is_in_solution(match, candidates[i]))
         {
-            *solution = code;
+            result = candidates[i];
+            break;
         }
     }
-
-    return candidates[0];
+    free(candidates);
+    free(solutions);
+    free(aggregations);
+    return result;
 }
 
-void set_pending_fb_scores()
+/*
+ * Summary: Builds what puzzle generation reads from the context: Pairwise feedbacks and feedback statistics.
+ *     Call before the context is shared by generators on several threads.
+ * Returns: false if the code space is too large for difficulty ranking
+ */
+bool qk_prepare_context(MM_Context *ctx)
 {
-    fb_scores_init = false;
+    return mm_init_feedback_lookup(ctx) && (mm_get_feedback_stats(ctx) != NULL);
 }
 
-void quickie(MM_Context *ctx)
+// Returns NULL if the context can't be prepared
+Quickie *qk_new(MM_Context *ctx, uint64_t seed)
 {
-    int difficulty;
-    if (!readline_int("Difficulty", NUM_DIFFICULTIES / 2, 1, NUM_DIFFICULTIES, &difficulty))
+    if (!qk_prepare_context(ctx))
     {
-        return;
+        return NULL;
     }
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    Quickie *result      = malloc(sizeof(Quickie));
+    *result              = (Quickie){ .ctx          = ctx,
+                                      .candidates   = malloc(num_codes * sizeof(Code_t)),
+                                      .solutions    = malloc(num_codes * sizeof(Code_t)),
+                                      .bucketed     = malloc(num_codes * sizeof(Code_t)),
+                                      .feedbacks    = malloc(num_codes * sizeof(Feedback_t)),
+                                      .aggregations = malloc(num_codes * sizeof(CodeSize_t)) };
+    result->num_fbs      = rank_feedbacks(ctx, result->fb_ranks);
+    rng_seed(&result->rng, seed);
+    return result;
+}
 
-    if (!fb_scores_init)
-    {
-        calculate_fb_scores(ctx);
-        fb_scores_init = true;
-    }
+void qk_free(Quickie *quickie)
+{
+    free(quickie->candidates);
+    free(quickie->solutions);
+    free(quickie->bucketed);
+    free(quickie->feedbacks);
+    free(quickie->aggregations);
+    free(quickie);
+}
+
+// The next puzzle only depends on seed, difficulty and the context's rules
+void qk_set_seed(Quickie *quickie, uint64_t seed)
+{
+    rng_seed(&quickie->rng, seed);
+}
+
+// qk_generate checks the flag once per turn and gives up as soon as it is non-zero
+void qk_set_cancel_flag(Quickie *quickie, const int *cancel)
+{
+    quickie->cancel = cancel;
+}
 
-    int score_min = (NUM_DIFFICULTIES - difficulty) * (num_fbs / NUM_DIFFICULTIES);
-    int score_max = score_min + (num_fbs / NUM_DIFFICULTIES);
+static bool is_canceled(const Quickie *quickie)
+{
+    return (quickie->cancel != NULL) && __atomic_load_n(quickie->cancel, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Summary: Computer plays minimax guesses until one solution is left, the solution is chosen along the way
+ *     so that feedbacks have a rank within the window of the difficulty (1: easy to QK_NUM_DIFFICULTIES: hard)
+ * Returns: false if generation was canceled, out_puzzle is incomplete then
+ */
+bool qk_generate(Quickie *quickie, int difficulty, QkPuzzle *out_puzzle)
+{
+    MM_Context *ctx = quickie->ctx;
+    int num_fbs     = quickie->num_fbs;
+    int score_min   = (QK_NUM_DIFFICULTIES - difficulty) * (num_fbs / QK_NUM_DIFFICULTIES);
+    int score_max   = score_min + (num_fbs / QK_NUM_DIFFICULTIES);
 
     if ((difficulty == 1) && (score_max != num_fbs - 1))
     {
@@ -260,35 +320,79 @@ void quickie(MM_Context *ctx)
     printf("Min score (incl.): %d, Max score (excl.): %d, #fb: %d\n", score_min, score_max, num_fbs);
 #endif
 
-    mm_init_feedback_lookup(ctx);
-    Code_t solution = rand() % mm_get_num_codes(ctx);
     MM_Match *match = mm_new_match(ctx, true);
-
-    printf("~ ~ %s ~ ~\n", difficulty_labels[difficulty - 1]);
-
-    while (mm_get_remaining_solutions(match) > 1)
+    *out_puzzle     = (QkPuzzle){ .difficulty = difficulty, .solution = mm_draw_code(ctx, &quickie->rng) };
+    while ((mm_get_remaining_solutions(match) > 1) && (mm_get_turns(match) < mm_get_max_guesses(ctx) - 1)
+           && !is_canceled(quickie))
     {
-        Code_t *candidates;
-        CodeSize_t num_candidates;
+        CodeSize_t num_candidates = mm_get_num_codes(ctx);
         if (mm_get_turns(match) == 0)
         {
-            candidates     = malloc(sizeof(Code_t) * mm_get_num_codes(ctx));
-            num_candidates = mm_get_num_codes(ctx);
-            for (Code_t i = 0; i < mm_get_num_codes(ctx); i++)
+            for (Code_t i = 0; i < num_candidates; i++)
             {
-                candidates[i] = i;
+                quickie->candidates[i] = i;
             }
         }
         else
         {
-            num_candidates = recommend_guess(match, &candidates);
+            num_candidates = recommend_guess(match, quickie->solutions, quickie->aggregations, quickie->candidates);
         }
 
-        Code_t guess = get_guess_and_solution(match, num_candidates, candidates, score_min, score_max, &solution);
-        mm_constrain(match, guess, mm_get_feedback(ctx, guess, solution));
+        Code_t guess = get_guess_and_solution(quickie, match, num_candidates, score_min, score_max, &out_puzzle->solution);
+        mm_constrain(match, guess, mm_get_feedback(ctx, guess, out_puzzle->solution));
+        out_puzzle->guesses[out_puzzle->num_guesses++] = guess;
+    }
+    mm_free_match(match);
+    return !is_canceled(quickie);
+}
+
+// Shows the auto-played guesses of puzzle, the player has one guess to find the solution
+static void play_puzzle(MM_Context *ctx, const QkPuzzle *puzzle)
+{
+    MM_Match *match = mm_new_match(ctx, true);
+    printf("~ ~ %s ~ ~\n", difficulty_labels[puzzle->difficulty - 1]);
+    for (int i = 0; i < puzzle->num_guesses; i++)
+    {
+        mm_constrain(match, puzzle->guesses[i], mm_get_feedback(ctx, puzzle->guesses[i], puzzle->solution));
+        print_guess(i, match, true);
+        printf("\n");
+    }
+
+    Code_t input;
+    if (read_colors(ctx, -1, &input))
+    {
+        mm_constrain(match, input, mm_get_feedback(ctx, input, puzzle->solution));
+        print_guess(mm_get_turns(match) - 1, match, true);
+        printf("\n");
+        print_match_end_message(match, puzzle->solution, false);
+    }
+    else
+    {
+        printf("\n");
+    }
+
+    mm_free_match(match);
+}
+
+/*
+ * Summary: Code space too large for difficulty ranking and exhaustive recommendations,
+ *     computer plays guesses of the evolutionary solver against a random solution instead
+ */
+static void quickie_without_enumeration(MM_Context *ctx)
+{
+    Code_t solution = mm_get_random_code(ctx);
+    MM_Match *match = mm_new_match(ctx, true);
+    RecOptions opts = { .criterion = REC_MOST_PARTS, .method = REC_METHOD_GENETIC };
+
+    printf("~ ~ Large configuration, no difficulty ~ ~\n");
+
+    while ((mm_get_remaining_solutions(match) > 1) && (mm_get_turns(match) < mm_get_max_guesses(ctx) - 1))
+    {
+        RecResult rec;
+        rec_recommend(match, &opts, &rec);
+        mm_constrain(match, rec.guess, mm_get_feedback(ctx, rec.guess, solution));
         print_guess(mm_get_turns(match) - 1, match, true);
         printf("\n");
-        free(candidates);
     }
 
     Code_t input;
@@ -306,3 +410,33 @@ void quickie(MM_Context *ctx)
 
     mm_free_match(match);
 }
+
+// Puzzles come from pool if given, otherwise they are generated now
+void quickie(MM_Context *ctx, PuzzlePool *pool)
+{
+    // Difficulty ranking and recommendations need pairwise feedbacks
+    if ((pool != NULL) ? !pp_is_available(pool) : !qk_prepare_context(ctx))
+    {
+        quickie_without_enumeration(ctx);
+        return;
+    }
+
+    int difficulty;
+    if (!readline_int("Difficulty", QK_NUM_DIFFICULTIES / 2, 1, QK_NUM_DIFFICULTIES, &difficulty))
+    {
+        return;
+    }
+
+    QkPuzzle puzzle;
+    if (pool != NULL)
+    {
+        pp_take(pool, difficulty, &puzzle);
+    }
+    else
+    {
+        Quickie *generator = qk_new(ctx, rng_next(mm_get_rng(ctx)));
+        qk_generate(generator, difficulty, &puzzle);
+        qk_free(generator);
+    }
+    play_puzzle(ctx, &puzzle);
+}
@@ -1,4 +1,31 @@
+#pragma once
+#include <stdbool.h>
 #include "mastermind.h"
 
-void quickie(MM_Context *ctx);
-void set_pending_fb_scores();
+#define QK_NUM_DIFFICULTIES 3
+
+// Start of a fast mode game: Guesses the computer played and the solution they were answered for
+typedef struct
+{
+    int difficulty; // 1 (easy) to QK_NUM_DIFFICULTIES (hard)
+    Code_t solution;
+    int num_guesses;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+} QkPuzzle;
+
+/*
+ * Fast mode puzzle generator bound to a context: Holds its feedback ranks, random state and scratch buffers,
+ * generators on different threads share nothing mutable once the context is prepared.
+ */
+typedef struct Quickie Quickie;
+
+struct PuzzlePool;
+
+bool qk_prepare_context(MM_Context *ctx);
+Quickie *qk_new(MM_Context *ctx, uint64_t seed);
+void qk_free(Quickie *quickie);
+void qk_set_seed(Quickie *quickie, uint64_t seed);
+void qk_set_cancel_flag(Quickie *quickie, const int *cancel);
+bool qk_generate(Quickie *quickie, int difficulty, QkPuzzle *out_puzzle);
+void quickie(MM_Context *ctx, struct PuzzlePool *pool);
+Code_t quickie_get_guess(MM_Match *match);
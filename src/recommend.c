@@ -0,0 +1,751 @@
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "recommend.h"
+#include "mastermind.h"
+#include "consistent.h"
+#include "genetic.h"
+#include "util/timer.h"
+
+#define EPSILON             1e-9
+#define DEFAULT_MAX_SAMPLES 4096
+#define MIN_SAMPLES         64
+#define CONFIDENCE_Z        1.96 // 95% two-sided
+#define MAX_THREADS         16
+
+// Bit mask of colors that have not been used in any guess so far
+static uint32_t get_free_colors(MM_Match *match)
+{
+    MM_Context *ctx = mm_get_context(match);
+    uint32_t result = (1u << mm_get_num_colors(ctx)) - 1;
+    for (int i = 0; i < mm_get_turns(match); i++)
+    {
+        int colors[MM_MAX_NUM_SLOTS];
+        mm_code_to_colors(ctx, mm_get_history_guess(match, i), colors);
+        for (int j = 0; j < mm_get_num_slots(ctx); j++)
+        {
+            result &= ~(1u << colors[j]);
+        }
+    }
+    return result;
+}
+
+/*
+ * Summary: Guesses that only differ by a permutation of free colors yield the same partition.
+ *     A code is a representative iff its free colors occur in ascending order.
+ *     Before the first guess, slots are interchangeable as well, so additionally
+ *     colors must be sorted by slot and their multiplicities must be non-increasing.
+ */
+static bool is_representative(int num_slots, const int *colors, uint32_t free_colors, bool first_turn)
+{
+    uint32_t seen = 0;
+    for (int i = 0; i < num_slots; i++)
+    {
+        uint32_t bit = 1u << colors[i];
+        if ((free_colors & bit) && !(seen & bit))
+        {
+            uint32_t unseen = free_colors & ~seen;
+            if ((unseen & -unseen) != bit)
+            {
+                return false;
+            }
+            seen |= bit;
+        }
+    }
+
+    if (first_turn)
+    {
+        int run      = 1;
+        int prev_run = num_slots;
+        for (int i = 1; i <= num_slots; i++)
+        {
+            if ((i < num_slots) && (colors[i] == colors[i - 1]))
+            {
+                run++;
+                continue;
+            }
+            if (((i < num_slots) && (colors[i] < colors[i - 1])) || (run > prev_run))
+            {
+                return false;
+            }
+            prev_run = run;
+            run      = 1;
+        }
+    }
+    return true;
+}
+
+static int count_distinct_colors(int num_slots, const int *colors)
+{
+    uint32_t mask = 0;
+    int result    = 0;
+    for (int i = 0; i < num_slots; i++)
+    {
+        if (!(mask & (1u << colors[i])))
+        {
+            mask |= 1u << colors[i];
+            result++;
+        }
+    }
+    return result;
+}
+
+/*
+ * Summary: Returns codes worth evaluating in order of priority: Only symmetry representatives,
+ *     consistent codes first, then by number of distinct colors (descending).
+ *     Generation takes at most half of the time left until deadline_us, so that the rest is left
+ *     to score candidates, it stops early once at least one candidate was found.
+ * Returns: Number of candidates, 0 if out of memory. out_complete (optional) is set to false if
+ *     generation was stopped by the deadline.
+ */
+CodeSize_t rec_get_candidates(MM_Match *match, uint64_t deadline_us, Code_t **out_candidates, bool *out_complete)
+{
+    MM_Context *ctx      = mm_get_context(match);
+    int num_slots        = mm_get_num_slots(ctx);
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    uint32_t free_colors = get_free_colors(match);
+    bool first_turn      = (mm_get_turns(match) == 0);
+    int num_keys         = 2 * (num_slots + 1);
+    uint64_t now         = timer_now_us();
+    uint64_t stop_us     = (deadline_us > now) ? now + (deadline_us - now) / 2 : now;
+
+    // Representatives are collected unordered with their keys, then sorted by counting
+    CodeSize_t capacity       = 1024;
+    CodeSize_t num_candidates = 0;
+    Code_t *codes             = malloc(capacity * sizeof(Code_t));
+    uint8_t *keys             = malloc(capacity * sizeof(uint8_t));
+    CodeSize_t *offsets       = calloc(num_keys + 1, sizeof(CodeSize_t));
+    Code_t code               = 0;
+    *out_candidates           = NULL;
+
+    for (; (codes != NULL) && (keys != NULL) && (offsets != NULL) && (code < num_codes); code++)
+    {
+        if (((code % 4096) == 0) && (num_candidates != 0) && timer_expired(stop_us))
+        {
+            break;
+        }
+
+        int colors[MM_MAX_NUM_SLOTS];
+        mm_code_to_colors(ctx, code, colors);
+        if (!is_representative(num_slots, colors, free_colors, first_turn))
+        {
+            continue;
+        }
+
+        if (num_candidates == capacity)
+        {
+            capacity *= 2;
+            Code_t *new_codes = realloc(codes, capacity * sizeof(Code_t));
+            codes             = (new_codes != NULL) ? new_codes : codes;
+            uint8_t *new_keys = realloc(keys, capacity * sizeof(uint8_t));
+            keys              = (new_keys != NULL) ? new_keys : keys;
+            if ((new_codes == NULL) || (new_keys == NULL))
+            {
+                num_candidates = 0;
+                break;
+            }
+        }
+        codes[num_candidates] = code;
+        keys[num_candidates]  = (mm_is_in_solution(match, code) ? 0 : (num_slots + 1))
+                              + (num_slots - count_distinct_colors(num_slots, colors));
+        offsets[keys[num_candidates] + 1]++;
+        num_candidates++;
+    }
+
+    if ((num_candidates != 0) && (offsets != NULL))
+    {
+        *out_candidates = malloc(num_candidates * sizeof(Code_t));
+    }
+    if (*out_candidates == NULL)
+    {
+        num_candidates = 0;
+    }
+
+    for (int i = 0; (num_candidates != 0) && (i < num_keys); i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+    for (CodeSize_t i = 0; i < num_candidates; i++)
+    {
+        (*out_candidates)[offsets[keys[i]]++] = codes[i];
+    }
+    if (out_complete != NULL)
+    {
+        *out_complete = (code == num_codes);
+    }
+
+    free(codes);
+    free(keys);
+    free(offsets);
+    return num_candidates;
+}
+
+double rec_score_partition(RecCriterion criterion, CodeSize_t num_solutions, int num_feedbacks, const CodeSize_t *counts)
+{
+    double result = 0;
+    for (int i = 0; i < num_feedbacks; i++)
+    {
+        if (counts[i] == 0)
+        {
+            continue;
+        }
+        switch (criterion)
+        {
+        case REC_WORST_CASE:
+            if (counts[i] > result)
+            {
+                result = counts[i];
+            }
+            break;
+        case REC_EXPECTED_SIZE:
+            result += (double)counts[i] * counts[i] / num_solutions;
+            break;
+        case REC_ENTROPY:
+            result -= (double)counts[i] / num_solutions * log2((double)num_solutions / counts[i]);
+            break;
+        case REC_MOST_PARTS:
+            result--;
+            break;
+        }
+    }
+    return result;
+}
+
+// No guess can score better than one that splits the solutions evenly
+double rec_get_lower_bound(RecCriterion criterion, CodeSize_t num_solutions, int num_feedbacks)
+{
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+    for (int i = 0; i < num_feedbacks; i++)
+    {
+        counts[i] = num_solutions / num_feedbacks + ((CodeSize_t)i < num_solutions % num_feedbacks ? 1 : 0);
+    }
+    return rec_score_partition(criterion, num_solutions, num_feedbacks, counts);
+}
+
+static bool is_better(double score, bool consistent, double best_score, bool best_consistent)
+{
+    return (score < best_score - EPSILON)
+        || ((score < best_score + EPSILON) && consistent && !best_consistent);
+}
+
+// Evaluates candidates in order of priority until the time budget is exhausted, returns false if out of memory
+static bool recommend_exact(MM_Match *match, const RecOptions *options, RecResult *out_result)
+{
+    uint64_t deadline   = timer_deadline_us(options->budget_ms);
+    MM_Context *ctx     = mm_get_context(match);
+    int num_feedbacks   = mm_get_num_feedbacks(ctx);
+    Code_t *solutions   = malloc(mm_get_remaining_solutions(match) * sizeof(Code_t));
+    CodeSize_t num_sols = mm_get_solutions(match, solutions);
+    double lower_bound  = rec_get_lower_bound(options->criterion, num_sols, num_feedbacks);
+
+    if (num_sols == 1)
+    {
+        *out_result = (RecResult){ .guess          = solutions[0],
+                                   .score          = lower_bound,
+                                   .score_low      = lower_bound,
+                                   .score_high     = lower_bound,
+                                   .is_consistent  = true,
+                                   .is_optimal     = true,
+                                   .num_evaluated  = 1,
+                                   .num_candidates = 1 };
+        free(solutions);
+        return true;
+    }
+
+    Code_t *candidates;
+    bool complete;
+    CodeSize_t num_candidates = rec_get_candidates(match, deadline, &candidates, &complete);
+    *out_result               = (RecResult){ .num_candidates = num_candidates };
+    if (num_candidates == 0)
+    {
+        free(solutions);
+        return false;
+    }
+
+    for (CodeSize_t i = 0; i < num_candidates; i++)
+    {
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        if (num_sols == mm_get_num_codes(ctx))
+        {
+            mm_get_partition_range(ctx, candidates[i], 0, num_sols, counts);
+        }
+        else
+        {
+            mm_get_partition(ctx, candidates[i], solutions, num_sols, counts);
+        }
+        double score    = rec_score_partition(options->criterion, num_sols, num_feedbacks, counts);
+        bool consistent = mm_is_in_solution(match, candidates[i]);
+
+        if ((i == 0) || is_better(score, consistent, out_result->score, out_result->is_consistent))
+        {
+            out_result->guess         = candidates[i];
+            out_result->score         = score;
+            out_result->score_low     = score;
+            out_result->score_high    = score;
+            out_result->is_consistent = consistent;
+        }
+        out_result->num_evaluated++;
+
+        // Can't be improved upon
+        if (out_result->is_consistent && (out_result->score < lower_bound + EPSILON))
+        {
+            break;
+        }
+        if (timer_expired(deadline))
+        {
+            break;
+        }
+    }
+
+    out_result->is_optimal = ((out_result->num_evaluated == num_candidates) && complete)
+                          || (out_result->score < lower_bound + EPSILON);
+
+    free(candidates);
+    free(solutions);
+    return true;
+}
+
+/*
+ * Summary: Estimates score of a partition of num_solutions codes from the bucket counts of
+ *     a sample of size num_samples (drawn without replacement) and its confidence interval
+ */
+static double estimate_score(RecCriterion criterion,
+                             CodeSize_t num_solutions,
+                             CodeSize_t num_samples,
+                             int num_feedbacks,
+                             const CodeSize_t *counts,
+                             double *out_low,
+                             double *out_high)
+{
+    double n   = num_solutions;
+    double m   = num_samples;
+    double fpc = (num_solutions > 1) ? (n - m) / (n - 1) : 0; // Finite population correction
+
+    double max_p   = 0;
+    double sum_p2  = 0;
+    double sum_p3  = 0;
+    double sum_pl  = 0;
+    double sum_pl2 = 0;
+    int num_parts  = 0;
+    int singletons = 0;
+    for (int i = 0; i < num_feedbacks; i++)
+    {
+        if (counts[i] == 0)
+        {
+            continue;
+        }
+        double p = counts[i] / m;
+        if (p > max_p)
+        {
+            max_p = p;
+        }
+        sum_p2 += p * p;
+        sum_p3 += p * p * p;
+        sum_pl += p * log2(p);
+        sum_pl2 += p * log2(p) * log2(p);
+        num_parts++;
+        if (counts[i] == 1)
+        {
+            singletons++;
+        }
+    }
+
+    double result = 0;
+    double delta  = 0;
+    switch (criterion)
+    {
+    case REC_WORST_CASE:
+        result = n * max_p;
+        delta  = CONFIDENCE_Z * n * sqrt(max_p * (1 - max_p) / m * fpc);
+        break;
+    case REC_EXPECTED_SIZE:
+        result = n * sum_p2;
+        delta  = CONFIDENCE_Z * n * sqrt(fabs(4 * (sum_p3 - sum_p2 * sum_p2)) / m * fpc);
+        break;
+    case REC_ENTROPY:
+        result = sum_pl;
+        delta  = CONFIDENCE_Z * sqrt(fabs(sum_pl2 - sum_pl * sum_pl) / m * fpc);
+        break;
+    case REC_MOST_PARTS:
+        // Observed parts are a lower bound, unseen parts are estimated by Good-Turing
+        *out_low  = -num_parts - ceil(singletons * fpc);
+        *out_high = -num_parts;
+        return -num_parts;
+    }
+
+    *out_low  = result - delta;
+    *out_high = result + delta;
+    return result;
+}
+
+typedef struct
+{
+    Code_t code;
+    bool consistent;
+    double score;
+    double low;
+    double high;
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+} SampledCandidate;
+
+/*
+ * Summary: Racing over growing samples: All candidates are scored on a small sample,
+ *     candidates whose confidence interval doesn't overlap with the leader's are dropped,
+ *     the sample is doubled for the remaining ones until one is left or the sample is exhausted
+ * Returns: False if out of memory
+ */
+static bool recommend_sampled(MM_Match *match, const RecOptions *options, RecResult *out_result)
+{
+    uint64_t deadline      = timer_deadline_us(options->budget_ms);
+    MM_Context *ctx        = mm_get_context(match);
+    int num_feedbacks      = mm_get_num_feedbacks(ctx);
+    CodeSize_t num_sols    = mm_get_remaining_solutions(match);
+    CodeSize_t max_samples = (options->max_samples != 0) ? options->max_samples : DEFAULT_MAX_SAMPLES;
+    Code_t *sample         = malloc(((num_sols < max_samples) ? num_sols : max_samples) * sizeof(Code_t));
+    CodeSize_t num_sample  = mm_sample_solutions(match, mm_get_match_rng(match), max_samples, sample);
+
+    Code_t *codes;
+    bool complete;
+    CodeSize_t num_alive         = rec_get_candidates(match, deadline, &codes, &complete);
+    SampledCandidate *candidates = malloc(num_alive * sizeof(SampledCandidate));
+    if ((num_alive == 0) || (candidates == NULL))
+    {
+        free(codes);
+        free(candidates);
+        free(sample);
+        return false;
+    }
+    for (CodeSize_t i = 0; i < num_alive; i++)
+    {
+        candidates[i] = (SampledCandidate){ .code = codes[i], .consistent = mm_is_in_solution(match, codes[i]) };
+    }
+    *out_result = (RecResult){ .num_candidates = num_alive };
+    free(codes);
+
+    CodeSize_t num_used = 0;
+    CodeSize_t num_next = (num_sample < MIN_SAMPLES) ? num_sample : MIN_SAMPLES;
+    bool truncated      = !complete; // Candidates were dropped by the deadline instead of their scores
+    while (true)
+    {
+        // Extend partitions of all alive candidates to the next sample prefix
+        double best_high         = INFINITY;
+        CodeSize_t num_evaluated = 0;
+        for (CodeSize_t i = 0; i < num_alive; i++)
+        {
+            SampledCandidate *cand = &candidates[i];
+            CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+            mm_get_partition(ctx, cand->code, sample + num_used, num_next - num_used, counts);
+            for (int j = 0; j < num_feedbacks; j++)
+            {
+                cand->counts[j] += counts[j];
+            }
+            cand->score = estimate_score(options->criterion, num_sols, num_next, num_feedbacks, cand->counts, &cand->low, &cand->high);
+            if (cand->high < best_high)
+            {
+                best_high = cand->high;
+            }
+            num_evaluated++;
+            if (timer_expired(deadline))
+            {
+                break;
+            }
+        }
+        truncated = truncated || (num_evaluated < num_alive);
+        num_alive = num_evaluated;
+        num_used  = num_next;
+        out_result->num_evaluated += num_evaluated;
+
+        // Drop candidates that are worse than the leader with high confidence
+        CodeSize_t num_kept = 0;
+        for (CodeSize_t i = 0; i < num_alive; i++)
+        {
+            if (candidates[i].low <= best_high + EPSILON)
+            {
+                candidates[num_kept++] = candidates[i];
+            }
+        }
+        num_alive = num_kept;
+
+        if ((num_alive == 1) || (num_used == num_sample) || timer_expired(deadline))
+        {
+            break;
+        }
+        num_next = (2 * num_used < num_sample) ? 2 * num_used : num_sample;
+    }
+
+    for (CodeSize_t i = 0; i < num_alive; i++)
+    {
+        if ((i == 0) || is_better(candidates[i].score, candidates[i].consistent, out_result->score, out_result->is_consistent))
+        {
+            out_result->guess         = candidates[i].code;
+            out_result->score         = candidates[i].score;
+            out_result->score_low     = candidates[i].low;
+            out_result->score_high    = candidates[i].high;
+            out_result->is_consistent = candidates[i].consistent;
+        }
+    }
+
+    // Once the sample has grown to all remaining solutions, the scores of the kept candidates are exact
+    out_result->is_optimal = (num_used == num_sols) && !truncated;
+
+    free(candidates);
+    free(sample);
+    return true;
+}
+
+/*
+ * Summary: Recommends a guess for match according to options
+ * Returns: False if method needs an enumerated solution space but it is not available for match,
+ *     if no solution is left or if out of memory
+ */
+bool rec_recommend(MM_Match *match, const RecOptions *options, RecResult *out_result)
+{
+    if (options->method == REC_METHOD_CONSISTENT)
+    {
+        *out_result = (RecResult){ .is_consistent = true, .num_evaluated = 1, .num_candidates = 1 };
+        return csp_find_consistent(match, true, &out_result->guess);
+    }
+    if (options->method == REC_METHOD_GENETIC)
+    {
+        GaOptions ga_options      = ga_get_default_options();
+        ga_options.criterion      = options->criterion;
+        ga_options.deadline_us    = timer_deadline_us(options->budget_ms);
+        *out_result               = (RecResult){ .num_evaluated = 1, .num_candidates = 1 };
+        out_result->is_consistent = ga_find_guess(match, &ga_options, &out_result->guess);
+        if (!out_result->is_consistent)
+        {
+            // Evolution didn't reach a consistent code, e.g. because only few are left
+            out_result->is_consistent = csp_find_consistent(match, true, &out_result->guess);
+        }
+        return true;
+    }
+
+    if (!mm_is_enumerable(mm_get_context(match))
+        || !mm_is_solution_counting_enabled(match)
+        || (mm_get_remaining_solutions(match) == 0))
+    {
+        return false;
+    }
+
+    switch (options->method)
+    {
+    case REC_METHOD_EXACT:
+        return recommend_exact(match, options, out_result);
+    case REC_METHOD_SAMPLED:
+        return recommend_sampled(match, options, out_result);
+    case REC_METHOD_CONSISTENT:
+    case REC_METHOD_GENETIC:
+        break;
+    }
+    return true;
+}
+
+// Shared state of the threads of rec_get_top_k, each thread evaluates every num_threads-th candidate
+typedef struct
+{
+    MM_Match *match;
+    RecCriterion criterion;
+    uint64_t deadline;
+    const int *cancel; // Set by another thread to stop early, NULL: Never
+    int num_threads;
+    const Code_t *solutions;
+    CodeSize_t num_sols;
+    const Code_t *candidates;
+    CodeSize_t num_candidates;
+    RecScore *scores;
+    bool *evaluated;
+} TopKJob;
+
+typedef struct
+{
+    TopKJob *job;
+    int index;
+} TopKWorker;
+
+static void *run_top_k_worker(void *arg)
+{
+    TopKWorker *worker = arg;
+    TopKJob *job       = worker->job;
+    MM_Context *ctx    = mm_get_context(job->match);
+    int num_feedbacks  = mm_get_num_feedbacks(ctx);
+
+    for (CodeSize_t i = worker->index; i < job->num_candidates; i += job->num_threads)
+    {
+        // Highest priority candidate is always evaluated
+        if ((i != 0) && (timer_expired(job->deadline) || ((job->cancel != NULL) && __atomic_load_n(job->cancel, __ATOMIC_ACQUIRE))))
+        {
+            break;
+        }
+
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        if (job->num_sols == mm_get_num_codes(ctx))
+        {
+            mm_get_partition_range(ctx, job->candidates[i], 0, job->num_sols, counts);
+        }
+        else
+        {
+            mm_get_partition(ctx, job->candidates[i], job->solutions, job->num_sols, counts);
+        }
+        job->scores[i] = (RecScore){
+            .guess         = job->candidates[i],
+            .score         = rec_score_partition(job->criterion, job->num_sols, num_feedbacks, counts),
+            .worst_case    = (CodeSize_t)rec_score_partition(REC_WORST_CASE, job->num_sols, num_feedbacks, counts),
+            .expected_size = rec_score_partition(REC_EXPECTED_SIZE, job->num_sols, num_feedbacks, counts),
+            .is_consistent = mm_is_in_solution(job->match, job->candidates[i])
+        };
+        job->evaluated[i] = true;
+    }
+    return NULL;
+}
+
+// Better score first, ties are broken by expected size, consistency and code
+static int compare_scores(const void *a, const void *b)
+{
+    const RecScore *score_a = a;
+    const RecScore *score_b = b;
+    if (fabs(score_a->score - score_b->score) > EPSILON)
+    {
+        return (score_a->score < score_b->score) ? -1 : 1;
+    }
+    if (fabs(score_a->expected_size - score_b->expected_size) > EPSILON)
+    {
+        return (score_a->expected_size < score_b->expected_size) ? -1 : 1;
+    }
+    if (score_a->is_consistent != score_b->is_consistent)
+    {
+        return score_a->is_consistent ? -1 : 1;
+    }
+    return (score_a->guess > score_b->guess) - (score_a->guess < score_b->guess);
+}
+
+/*
+ * Summary: Evaluates candidates in order of priority on one thread per core until the time budget
+ *     is exhausted or cancel is set and writes the k best of them into out_scores, best first
+ * Returns: Number of scores written, 0 if no enumerated solution space is available or if out of memory
+ */
+int rec_get_top_k(MM_Match *match, RecCriterion criterion, int budget_ms, const int *cancel, int k, RecScore *out_scores)
+{
+    MM_Context *ctx = mm_get_context(match);
+    if (!mm_is_enumerable(ctx) || !mm_is_solution_counting_enabled(match) || (mm_get_remaining_solutions(match) == 0))
+    {
+        return 0;
+    }
+
+    TopKJob job = { .match     = match,
+                    .criterion = criterion,
+                    .deadline  = timer_deadline_us(budget_ms),
+                    .cancel    = cancel,
+                    .num_sols  = mm_get_remaining_solutions(match) };
+
+    // Without any guess, partitions are computed over the code range instead
+    Code_t *solutions = NULL;
+    if (job.num_sols != mm_get_num_codes(ctx))
+    {
+        solutions = malloc(job.num_sols * sizeof(Code_t));
+        if (solutions == NULL)
+        {
+            return 0;
+        }
+        mm_get_solutions(match, solutions);
+    }
+    Code_t *candidates;
+    job.solutions      = solutions;
+    job.num_candidates = rec_get_candidates(match, job.deadline, &candidates, NULL);
+    job.candidates     = candidates;
+    job.scores         = malloc(job.num_candidates * sizeof(RecScore));
+    job.evaluated      = calloc(job.num_candidates, sizeof(bool));
+    if ((job.num_candidates == 0) || (job.scores == NULL) || (job.evaluated == NULL))
+    {
+        free(solutions);
+        free(candidates);
+        free(job.scores);
+        free(job.evaluated);
+        return 0;
+    }
+
+    long num_cores  = sysconf(_SC_NPROCESSORS_ONLN);
+    job.num_threads = (num_cores < 1) ? 1 : ((num_cores > MAX_THREADS) ? MAX_THREADS : num_cores);
+    if ((CodeSize_t)job.num_threads > job.num_candidates)
+    {
+        job.num_threads = job.num_candidates;
+    }
+
+    pthread_t threads[MAX_THREADS];
+    TopKWorker workers[MAX_THREADS];
+    bool started[MAX_THREADS];
+    for (int i = 0; i < job.num_threads; i++)
+    {
+        workers[i] = (TopKWorker){ .job = &job, .index = i };
+        started[i] = (pthread_create(&threads[i], NULL, run_top_k_worker, &workers[i]) == 0);
+    }
+    for (int i = 0; i < job.num_threads; i++)
+    {
+        // Out of threads: The worker runs on this one
+        if (!started[i])
+        {
+            run_top_k_worker(&workers[i]);
+        }
+    }
+    for (int i = 0; i < job.num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // Compact evaluated candidates, then sort them
+    CodeSize_t num_evaluated = 0;
+    for (CodeSize_t i = 0; i < job.num_candidates; i++)
+    {
+        if (job.evaluated[i])
+        {
+            job.scores[num_evaluated++] = job.scores[i];
+        }
+    }
+    qsort(job.scores, num_evaluated, sizeof(RecScore), compare_scores);
+
+    int result = ((CodeSize_t)k < num_evaluated) ? k : (int)num_evaluated;
+    for (int i = 0; i < result; i++)
+    {
+        out_scores[i] = job.scores[i];
+    }
+
+    free(solutions);
+    free(candidates);
+    free(job.scores);
+    free(job.evaluated);
+    return result;
+}
+
+void rec_get_position(MM_Match *match, RecPosition *out_position)
+{
+    MM_Context *ctx = mm_get_context(match);
+    memset(out_position, 0, sizeof(RecPosition)); // Padding is hashed as well
+    out_position->num_slots  = mm_get_num_slots(ctx);
+    out_position->num_colors = mm_get_num_colors(ctx);
+    out_position->rules      = mm_get_rules(ctx);
+    out_position->num_turns  = mm_get_turns(match);
+
+    // Insertion sort by guess, then feedback
+    for (int i = 0; i < out_position->num_turns; i++)
+    {
+        Code_t guess  = mm_get_history_guess(match, i);
+        Feedback_t fb = mm_get_history_feedback(match, i);
+        int j         = i;
+        while ((j > 0)
+               && ((out_position->guesses[j - 1] > guess)
+                   || ((out_position->guesses[j - 1] == guess) && (out_position->feedbacks[j - 1] > fb))))
+        {
+            out_position->guesses[j]   = out_position->guesses[j - 1];
+            out_position->feedbacks[j] = out_position->feedbacks[j - 1];
+            j--;
+        }
+        out_position->guesses[j]   = guess;
+        out_position->feedbacks[j] = fb;
+    }
+}
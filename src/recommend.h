@@ -0,0 +1,67 @@
+#pragma once
+#include <stdbool.h>
+#include "mastermind.h"
+
+typedef enum
+{
+    REC_WORST_CASE,    // Minimize size of largest partition (Knuth)
+    REC_EXPECTED_SIZE, // Minimize expected size of partition
+    REC_ENTROPY,       // Maximize information gain
+    REC_MOST_PARTS     // Maximize number of non-empty partitions
+} RecCriterion;
+
+typedef enum
+{
+    REC_METHOD_EXACT,      // Full partition pass over all remaining solutions
+    REC_METHOD_SAMPLED,    // Partitions estimated from a random sample of remaining solutions
+    REC_METHOD_CONSISTENT, // Any consistent code by constraint search, needs no enumeration
+    REC_METHOD_GENETIC     // Evolutionary search on parallel islands, needs no enumeration
+} RecMethod;
+
+typedef struct
+{
+    RecCriterion criterion;
+    RecMethod method;
+    int budget_ms;          // <= 0: Run to completion
+    CodeSize_t max_samples; // Only for REC_METHOD_SAMPLED, 0: Default
+} RecOptions;
+
+typedef struct
+{
+    Code_t guess;
+    double score;     // Lower is better
+    double score_low; // Confidence interval of score, equal to score if exact
+    double score_high;
+    bool is_consistent;
+    bool is_optimal; // Proven to be optimal for criterion
+    CodeSize_t num_evaluated;
+    CodeSize_t num_candidates;
+} RecResult;
+
+// Scores of a single guess, as returned by rec_get_top_k
+typedef struct
+{
+    Code_t guess;
+    double score;          // For criterion, lower is better
+    CodeSize_t worst_case; // Size of largest partition
+    double expected_size;  // Expected number of remaining solutions after guess
+    bool is_consistent;
+} RecScore;
+
+// Solution space only depends on the set of guesses and feedbacks, so history is sorted to be used as cache key
+typedef struct
+{
+    int num_slots;
+    int num_colors;
+    int rules;
+    int num_turns;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    Feedback_t feedbacks[MM_MAX_MAX_GUESSES];
+} RecPosition;
+
+bool rec_recommend(MM_Match *match, const RecOptions *options, RecResult *out_result);
+CodeSize_t rec_get_candidates(MM_Match *match, uint64_t deadline_us, Code_t **out_candidates, bool *out_complete);
+double rec_score_partition(RecCriterion criterion, CodeSize_t num_solutions, int num_feedbacks, const CodeSize_t *counts);
+double rec_get_lower_bound(RecCriterion criterion, CodeSize_t num_solutions, int num_feedbacks);
+void rec_get_position(MM_Match *match, RecPosition *out_position);
+int rec_get_top_k(MM_Match *match, RecCriterion criterion, int budget_ms, const int *cancel, int k, RecScore *out_scores);
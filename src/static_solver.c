@@ -0,0 +1,456 @@
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "static_solver.h"
+#include "recommend.h"
+#include "util/timer.h"
+
+/*
+ * Searches the smallest set of guesses whose feedbacks identify every secret.
+ * The guesses of a set induce a partition of the code space, each guess refines it by its feedbacks
+ * (class, feedback) -> new class. A set solves the problem iff all classes are single codes.
+ * Greedy refinement gives an upper bound, then sets of at most one guess less are searched depth-first
+ * until the search is exhausted, which proves the last set found to be minimal:
+ *     - The first guess is a symmetry representative (colors and slots are interchangeable),
+ *       the others are taken in ascending order
+ *     - Guesses that don't split any class are skipped, they can't be part of a minimal set
+ *     - Branches are cut if a class is larger than num_feedbacks^(guesses left)
+ *     - Children are tried in order of the number of classes they create
+ * First guesses are distributed across threads.
+ */
+
+#define MAX_THREADS    16
+#define CHECK_INTERVAL 64 // Nodes between checks of deadline and other threads
+
+typedef struct
+{
+    Code_t guess;
+    uint32_t num_classes;
+} Candidate;
+
+typedef struct
+{
+    MM_Context *ctx;
+    CodeSize_t num_codes;
+    int num_feedbacks;
+    int size; // Size of the sets searched
+    uint64_t deadline_us;
+    const Code_t *roots;
+    CodeSize_t num_roots;
+
+    pthread_mutex_t mutex; // Protects the following members
+    CodeSize_t next_root;
+    bool found;
+    bool expired;
+    Code_t solution[MM_MAX_MAX_GUESSES];
+    int solution_size;
+    uint64_t num_nodes;
+} Solver;
+
+typedef struct
+{
+    Solver *solver;
+    uint32_t *classes[MM_MAX_MAX_GUESSES + 1]; // Class of each code after each depth
+    uint32_t num_classes[MM_MAX_MAX_GUESSES + 1];
+    Candidate *candidates[MM_MAX_MAX_GUESSES];
+    Feedback_t *feedbacks;
+    uint32_t *ids;    // New class of (class, feedback), valid if stamp matches
+    uint32_t *stamps; // num_codes * num_feedbacks
+    uint32_t *sizes;
+    uint32_t stamp;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    int num_guesses; // Of the set found
+    uint64_t num_nodes;
+    bool stopped;
+} Worker;
+
+// num_feedbacks^exponent, saturating
+static uint64_t get_capacity(int num_feedbacks, int exponent)
+{
+    uint64_t result = 1;
+    for (int i = 0; i < exponent; i++)
+    {
+        if (result > UINT64_MAX / num_feedbacks)
+        {
+            return UINT64_MAX;
+        }
+        result *= num_feedbacks;
+    }
+    return result;
+}
+
+static void init_worker(Solver *solver, Worker *out_worker)
+{
+    size_t num_keys = (size_t)solver->num_codes * solver->num_feedbacks;
+    *out_worker     = (Worker){ .solver    = solver,
+                                .feedbacks = malloc(solver->num_codes * sizeof(Feedback_t)),
+                                .ids       = malloc(num_keys * sizeof(uint32_t)),
+                                .stamps    = calloc(num_keys, sizeof(uint32_t)),
+                                .sizes     = malloc(solver->num_codes * sizeof(uint32_t)) };
+    for (int i = 0; i <= MM_MAX_MAX_GUESSES; i++)
+    {
+        out_worker->classes[i] = calloc(solver->num_codes, sizeof(uint32_t));
+    }
+    for (int i = 0; i < MM_MAX_MAX_GUESSES; i++)
+    {
+        out_worker->candidates[i] = malloc(solver->num_codes * sizeof(Candidate));
+    }
+    out_worker->num_classes[0] = 1;
+}
+
+static void destroy_worker(Worker *worker)
+{
+    for (int i = 0; i <= MM_MAX_MAX_GUESSES; i++)
+    {
+        free(worker->classes[i]);
+    }
+    for (int i = 0; i < MM_MAX_MAX_GUESSES; i++)
+    {
+        free(worker->candidates[i]);
+    }
+    free(worker->feedbacks);
+    free(worker->ids);
+    free(worker->stamps);
+    free(worker->sizes);
+}
+
+/*
+ * Summary: Refines partition at depth by guess, writes it to depth + 1 if write is set
+ * Returns: Number of classes of the refined partition
+ */
+static uint32_t refine(Worker *worker, int depth, Code_t guess, bool write, uint32_t *out_max_size)
+{
+    Solver *solver = worker->solver;
+    if (++worker->stamp == 0)
+    {
+        memset(worker->stamps, 0, (size_t)solver->num_codes * solver->num_feedbacks * sizeof(uint32_t));
+        worker->stamp = 1;
+    }
+
+    mm_get_feedbacks_range(solver->ctx, guess, 0, solver->num_codes, worker->feedbacks);
+    const uint32_t *classes = worker->classes[depth];
+    uint32_t result         = 0;
+    uint32_t max_size       = 0;
+    for (CodeSize_t i = 0; i < solver->num_codes; i++)
+    {
+        size_t key = (size_t)classes[i] * solver->num_feedbacks + worker->feedbacks[i];
+        if (worker->stamps[key] != worker->stamp)
+        {
+            worker->stamps[key]     = worker->stamp;
+            worker->ids[key]        = result;
+            worker->sizes[result++] = 0;
+        }
+        if (write)
+        {
+            uint32_t id                   = worker->ids[key];
+            worker->classes[depth + 1][i] = id;
+            max_size                      = (++worker->sizes[id] > max_size) ? worker->sizes[id] : max_size;
+        }
+    }
+    if (write)
+    {
+        worker->num_classes[depth + 1] = result;
+        *out_max_size                  = max_size;
+    }
+    return result;
+}
+
+static bool is_stopped(Worker *worker)
+{
+    Solver *solver = worker->solver;
+    if (!worker->stopped && (++worker->num_nodes % CHECK_INTERVAL == 0))
+    {
+        pthread_mutex_lock(&solver->mutex);
+        if ((solver->deadline_us != 0) && timer_expired(solver->deadline_us))
+        {
+            solver->expired = true;
+        }
+        worker->stopped = solver->found || solver->expired;
+        pthread_mutex_unlock(&solver->mutex);
+    }
+    return worker->stopped;
+}
+
+static int compare_candidates(const void *a, const void *b)
+{
+    const Candidate *x = a;
+    const Candidate *y = b;
+    if (x->num_classes != y->num_classes)
+    {
+        return (x->num_classes < y->num_classes) ? 1 : -1;
+    }
+    return (x->guess > y->guess) - (x->guess < y->guess);
+}
+
+// Depth-first search for the remaining guesses, taken in ascending order from first
+static bool search(Worker *worker, int depth, Code_t first)
+{
+    Solver *solver = worker->solver;
+    if (worker->num_classes[depth] == solver->num_codes)
+    {
+        worker->num_guesses = depth;
+        return true;
+    }
+    if ((depth == solver->size) || is_stopped(worker))
+    {
+        return false;
+    }
+
+    Candidate *candidates = worker->candidates[depth];
+    CodeSize_t num_cands  = 0;
+    bool is_last          = (depth + 1 == solver->size);
+    for (Code_t guess = first; guess < solver->num_codes; guess++)
+    {
+        uint32_t num_classes = refine(worker, depth, guess, false, NULL);
+        if ((num_classes > worker->num_classes[depth]) && (!is_last || (num_classes == solver->num_codes)))
+        {
+            candidates[num_cands++] = (Candidate){ .guess = guess, .num_classes = num_classes };
+        }
+    }
+    qsort(candidates, num_cands, sizeof(Candidate), compare_candidates);
+
+    uint64_t capacity = get_capacity(solver->num_feedbacks, solver->size - depth - 1);
+    for (CodeSize_t i = 0; i < num_cands; i++)
+    {
+        uint32_t max_size;
+        refine(worker, depth, candidates[i].guess, true, &max_size);
+        if (max_size > capacity)
+        {
+            continue;
+        }
+        worker->guesses[depth] = candidates[i].guess;
+        if (search(worker, depth + 1, candidates[i].guess + 1))
+        {
+            return true;
+        }
+        if (is_stopped(worker))
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+static void *run_worker(void *arg)
+{
+    Solver *solver = arg;
+    Worker worker;
+    init_worker(solver, &worker);
+
+    uint64_t capacity = get_capacity(solver->num_feedbacks, solver->size - 1);
+    while (!worker.stopped)
+    {
+        pthread_mutex_lock(&solver->mutex);
+        CodeSize_t root = solver->next_root++;
+        pthread_mutex_unlock(&solver->mutex);
+        if (root >= solver->num_roots)
+        {
+            break;
+        }
+
+        uint32_t max_size;
+        refine(&worker, 0, solver->roots[root], true, &max_size);
+        worker.guesses[0] = solver->roots[root];
+        if ((max_size <= capacity) && search(&worker, 1, 0))
+        {
+            pthread_mutex_lock(&solver->mutex);
+            if (!solver->found)
+            {
+                solver->found         = true;
+                solver->solution_size = worker.num_guesses;
+                memcpy(solver->solution, worker.guesses, worker.num_guesses * sizeof(Code_t));
+            }
+            pthread_mutex_unlock(&solver->mutex);
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&solver->mutex);
+    solver->num_nodes += worker.num_nodes;
+    pthread_mutex_unlock(&solver->mutex);
+    destroy_worker(&worker);
+    return NULL;
+}
+
+// Repeatedly takes the guess that creates most classes, returns size of the set or 0 if it gets too large
+static int get_greedy_set(Solver *solver, Code_t *out_guesses)
+{
+    Worker worker;
+    init_worker(solver, &worker);
+    int depth = 0;
+    while ((worker.num_classes[depth] < solver->num_codes) && (depth < MM_MAX_MAX_GUESSES))
+    {
+        Code_t best         = 0;
+        uint32_t best_count = 0;
+        for (Code_t guess = 0; guess < solver->num_codes; guess++)
+        {
+            uint32_t count = refine(&worker, depth, guess, false, NULL);
+            if (count > best_count)
+            {
+                best       = guess;
+                best_count = count;
+            }
+        }
+        uint32_t max_size;
+        refine(&worker, depth, best, true, &max_size);
+        out_guesses[depth++] = best;
+    }
+    bool complete = (worker.num_classes[depth] == solver->num_codes);
+    destroy_worker(&worker);
+    return complete ? depth : 0;
+}
+
+SsOptions ss_get_default_options()
+{
+    return (SsOptions){ .budget_ms = 10000, .num_threads = 0 };
+}
+
+/*
+ * Summary: Searches the smallest set of guesses that identifies every secret,
+ *     the code space must not be larger than MM_MAX_LOOKUP_CODES
+ * Returns: False if there are too many codes, otherwise the smallest set found
+ */
+bool ss_solve(MM_Context *ctx, const SsOptions *options, SsResult *out_result)
+{
+    if (mm_get_num_codes(ctx) > MM_MAX_LOOKUP_CODES)
+    {
+        return false;
+    }
+    mm_init_feedback_lookup(ctx);
+
+    Solver solver = { .ctx           = ctx,
+                      .num_codes     = mm_get_num_codes(ctx),
+                      .num_feedbacks = mm_get_num_feedbacks(ctx),
+                      .deadline_us   = (options->budget_ms > 0) ? timer_deadline_us(options->budget_ms) : 0 };
+    pthread_mutex_init(&solver.mutex, NULL);
+
+    *out_result             = (SsResult){ 0 };
+    out_result->num_guesses = get_greedy_set(&solver, out_result->guesses);
+    if ((out_result->num_guesses == 0) && (solver.num_codes > 1))
+    {
+        pthread_mutex_destroy(&solver.mutex);
+        return false;
+    }
+    while (get_capacity(solver.num_feedbacks, out_result->lower_bound) < solver.num_codes)
+    {
+        out_result->lower_bound++;
+    }
+
+    // Roots: Symmetry representatives of the first guess
+    Code_t *roots;
+    MM_Match *match  = mm_new_match(ctx, true);
+    solver.num_roots = rec_get_candidates(match, timer_deadline_us(0), &roots, NULL);
+    solver.roots     = roots;
+    mm_free_match(match);
+    if (solver.num_roots == 0)
+    {
+        pthread_mutex_destroy(&solver.mutex);
+        return false;
+    }
+
+    int num_threads = (options->num_threads > 0) ? options->num_threads : sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads     = (num_threads < 1) ? 1 : ((num_threads > MAX_THREADS) ? MAX_THREADS : num_threads);
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+
+    while (!solver.expired && (out_result->lower_bound < out_result->num_guesses))
+    {
+        solver.size      = out_result->num_guesses - 1;
+        solver.next_root = 0;
+        solver.found     = false;
+        for (int i = 0; i < num_threads; i++)
+        {
+            started[i] = (pthread_create(&threads[i], NULL, run_worker, &solver) == 0);
+        }
+        for (int i = 0; i < num_threads; i++)
+        {
+            // Workers take roots from a shared index, so this one takes over for any that didn't start
+            if (!started[i])
+            {
+                run_worker(&solver);
+            }
+        }
+        for (int i = 0; i < num_threads; i++)
+        {
+            if (started[i])
+            {
+                pthread_join(threads[i], NULL);
+            }
+        }
+
+        if (solver.found)
+        {
+            out_result->num_guesses = solver.solution_size;
+            memcpy(out_result->guesses, solver.solution, solver.solution_size * sizeof(Code_t));
+        }
+        else if (!solver.expired)
+        {
+            out_result->lower_bound = out_result->num_guesses; // Search was exhausted, no smaller set exists
+        }
+    }
+
+    out_result->is_optimal = (out_result->lower_bound == out_result->num_guesses);
+    out_result->num_nodes  = solver.num_nodes;
+    free(roots);
+    pthread_mutex_destroy(&solver.mutex);
+    return true;
+}
+
+uint64_t ss_get_key(MM_Context *ctx, int num_guesses, const Feedback_t *feedbacks)
+{
+    uint64_t result = 0;
+    for (int i = num_guesses - 1; i >= 0; i--)
+    {
+        result = result * mm_get_num_feedbacks(ctx) + feedbacks[i];
+    }
+    return result;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    uint64_t x = ((const SsEntry *)a)->key;
+    uint64_t y = ((const SsEntry *)b)->key;
+    return (x > y) - (x < y);
+}
+
+// Table from feedback vector to secret, keys are not unique if the guesses don't identify every secret
+SsTable ss_create_table(MM_Context *ctx, int num_guesses, const Code_t *guesses)
+{
+    SsTable result = { .ctx         = ctx,
+                       .num_guesses = num_guesses,
+                       .num_entries = mm_get_num_codes(ctx),
+                       .entries     = malloc(mm_get_num_codes(ctx) * sizeof(SsEntry)) };
+    memcpy(result.guesses, guesses, num_guesses * sizeof(Code_t));
+
+    for (Code_t secret = 0; secret < result.num_entries; secret++)
+    {
+        Feedback_t feedbacks[MM_MAX_MAX_GUESSES];
+        for (int i = 0; i < num_guesses; i++)
+        {
+            feedbacks[i] = mm_get_feedback(ctx, guesses[i], secret);
+        }
+        result.entries[secret] = (SsEntry){ .key = ss_get_key(ctx, num_guesses, feedbacks), .secret = secret };
+    }
+    qsort(result.entries, result.num_entries, sizeof(SsEntry), compare_entries);
+    return result;
+}
+
+// Returns false if no secret yields the feedbacks
+bool ss_lookup(const SsTable *table, const Feedback_t *feedbacks, Code_t *out_secret)
+{
+    SsEntry key    = { .key = ss_get_key(table->ctx, table->num_guesses, feedbacks) };
+    SsEntry *entry = bsearch(&key, table->entries, table->num_entries, sizeof(SsEntry), compare_entries);
+    if (entry != NULL)
+    {
+        *out_secret = entry->secret;
+    }
+    return entry != NULL;
+}
+
+void ss_destroy_table(SsTable *table)
+{
+    free(table->entries);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "mastermind.h"
+
+/*
+ * Static Mastermind: All guesses are submitted at once, the vector of their feedbacks
+ * must identify every secret.
+ */
+
+typedef struct
+{
+    int budget_ms;   // <= 0: Search until the smallest set is proven
+    int num_threads; // <= 0: One per core
+} SsOptions;
+
+typedef struct
+{
+    int num_guesses;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    bool is_optimal; // No smaller set exists
+    int lower_bound; // Smallest size that wasn't ruled out
+    uint64_t num_nodes;
+} SsResult;
+
+// Feedback vector of the guesses (as key, unique while num_feedbacks^num_guesses < 2^64) and the secret it identifies
+typedef struct
+{
+    uint64_t key;
+    Code_t secret;
+} SsEntry;
+
+typedef struct
+{
+    MM_Context *ctx;
+    int num_guesses;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    CodeSize_t num_entries;
+    SsEntry *entries; // Sorted by key
+} SsTable;
+
+SsOptions ss_get_default_options();
+bool ss_solve(MM_Context *ctx, const SsOptions *options, SsResult *out_result);
+uint64_t ss_get_key(MM_Context *ctx, int num_guesses, const Feedback_t *feedbacks);
+SsTable ss_create_table(MM_Context *ctx, int num_guesses, const Code_t *guesses);
+bool ss_lookup(const SsTable *table, const Feedback_t *feedbacks, Code_t *out_secret);
+void ss_destroy_table(SsTable *table);
@@ -0,0 +1,147 @@
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strategy.h"
+#include "quickie.h"
+#include "recommend.h"
+
+typedef struct
+{
+    bool has_opening;
+    Code_t opening; // First guess is the same in every match
+} KnuthState;
+
+static void *init_knuth(MM_Context *ctx)
+{
+    (void)ctx;
+    return calloc(1, sizeof(KnuthState));
+}
+
+static Code_t choose_knuth(void *state, MM_Match *match)
+{
+    KnuthState *knuth = state;
+    if (mm_get_turns(match) != 0)
+    {
+        return quickie_get_guess(match);
+    }
+    if (!knuth->has_opening)
+    {
+        knuth->opening     = quickie_get_guess(match);
+        knuth->has_opening = true;
+    }
+    return knuth->opening;
+}
+
+static Code_t recommend(MM_Match *match, RecCriterion criterion, RecMethod method)
+{
+    RecOptions options = { .criterion = criterion, .method = method };
+    RecResult result;
+    if (!rec_recommend(match, &options, &result))
+    {
+        // Not enumerable or no solution left
+        options.method = REC_METHOD_GENETIC;
+        rec_recommend(match, &options, &result);
+    }
+    return result.guess;
+}
+
+static Code_t choose_worst_case(void *state, MM_Match *match)
+{
+    (void)state;
+    return recommend(match, REC_WORST_CASE, REC_METHOD_EXACT);
+}
+
+static Code_t choose_entropy(void *state, MM_Match *match)
+{
+    (void)state;
+    return recommend(match, REC_ENTROPY, REC_METHOD_EXACT);
+}
+
+static Code_t choose_sampled(void *state, MM_Match *match)
+{
+    (void)state;
+    return recommend(match, REC_EXPECTED_SIZE, REC_METHOD_SAMPLED);
+}
+
+static Code_t choose_consistent(void *state, MM_Match *match)
+{
+    (void)state;
+    return recommend(match, REC_WORST_CASE, REC_METHOD_CONSISTENT);
+}
+
+static Code_t choose_genetic(void *state, MM_Match *match)
+{
+    (void)state;
+    return recommend(match, REC_MOST_PARTS, REC_METHOD_GENETIC);
+}
+
+static const Strategy builtins[] = {
+    { "knuth", init_knuth, choose_knuth, free, STRAT_CODE_SIZE },     // Minimax of quickie over all codes, consistent codes first
+    { "worst-case", NULL, choose_worst_case, NULL, STRAT_CODE_SIZE }, // Exact recommender, symmetry reduced
+    { "entropy", NULL, choose_entropy, NULL, STRAT_CODE_SIZE },
+    { "sampled", NULL, choose_sampled, NULL, STRAT_CODE_SIZE },
+    { "consistent", NULL, choose_consistent, NULL, STRAT_CODE_SIZE }, // Random consistent code by constraint search
+    { "genetic", NULL, choose_genetic, NULL, STRAT_CODE_SIZE }
+};
+
+int strat_get_num_builtins()
+{
+    return sizeof(builtins) / sizeof(Strategy);
+}
+
+const Strategy *strat_get_builtin(int index)
+{
+    return &builtins[index];
+}
+
+/*
+ * Summary: Loads strategy from shared library, it stays loaded until the program exits
+ * Returns: NULL if the library can't be loaded, has no strategy for this ABI version or was built with another code width
+ */
+const Strategy *strat_load_plugin(const char *path)
+{
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL)
+    {
+        printf("%s\n", dlerror());
+        return NULL;
+    }
+
+    // Object to function pointer conversion isn't ISO C, copy the representation instead
+    StrategyEntry entry;
+    void *symbol = dlsym(handle, STRAT_ENTRY_SYMBOL);
+    memcpy(&entry, &symbol, sizeof(entry));
+
+    const Strategy *result = (symbol != NULL) ? entry(STRAT_ABI_VERSION) : NULL;
+    if ((result == NULL) || (result->name == NULL) || (result->choose == NULL))
+    {
+        printf("%s: No strategy for ABI version %d\n", path, STRAT_ABI_VERSION);
+        dlclose(handle);
+        return NULL;
+    }
+    if (result->code_size != STRAT_CODE_SIZE)
+    {
+        printf("%s: Built with %d bit codes, this executable uses %d bit codes (both must agree on -DMM_CODE_64)\n",
+               path,
+               8 * result->code_size,
+               8 * STRAT_CODE_SIZE);
+        dlclose(handle);
+        return NULL;
+    }
+    return result;
+}
+
+// Built-in strategy by name or plugin if name is a path, returns NULL if there is none
+const Strategy *strat_find(const char *name)
+{
+    for (int i = 0; i < strat_get_num_builtins(); i++)
+    {
+        if (strcmp(builtins[i].name, name) == 0)
+        {
+            return &builtins[i];
+        }
+    }
+    return (strchr(name, '/') != NULL) ? strat_load_plugin(name) : NULL;
+}
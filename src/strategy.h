@@ -0,0 +1,32 @@
+#pragma once
+#include "mastermind.h"
+
+/*
+ * Codebreaker strategy: init is called once per thread and context, its state is passed to choose,
+ * which returns the next guess for a pending match, and finally to free. init and free may be NULL.
+ */
+typedef struct
+{
+    const char *name;
+    void *(*init)(MM_Context *ctx);
+    Code_t (*choose)(void *state, MM_Match *match);
+    void (*free)(void *state);
+    int code_size; // STRAT_CODE_SIZE of the build, Code_t is wider with -DMM_CODE_64
+} Strategy;
+
+/*
+ * Plugins are shared libraries exporting STRAT_ENTRY_SYMBOL of type StrategyEntry. It is called with the
+ * ABI version of the host and returns its strategy, or NULL if it was built for another version.
+ * Plugins may call all functions of mastermind.h, they are resolved against the executable.
+ * The host rejects a strategy whose code_size differs from its own, as callbacks would disagree on Code_t.
+ */
+#define STRAT_ABI_VERSION  2
+#define STRAT_ENTRY_SYMBOL "mm_strategy_entry"
+#define STRAT_CODE_SIZE    ((int)sizeof(Code_t))
+
+typedef const Strategy *(*StrategyEntry)(int abi_version);
+
+int strat_get_num_builtins();
+const Strategy *strat_get_builtin(int index);
+const Strategy *strat_find(const char *name);
+const Strategy *strat_load_plugin(const char *path);
@@ -0,0 +1,583 @@
+#define _DEFAULT_SOURCE
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "analyzer.h"
+#include "../mastermind.h"
+#include "../recommend.h"
+#include "../util/hash_map.h"
+#include "../util/timer.h"
+#include "../util/vector.h"
+
+/*
+ * Offline analysis of recorded games: For each turn, the played guess is ranked among all guesses by information
+ * gain, entropy lost against the best guess and expected extra turns (entropy lost in turns of optimal play) are
+ * calculated. Games are spread across threads that share a transposition cache (sorted scores of all guesses
+ * for a position) and a partition cache for the first turns, where positions repeat between games.
+ */
+
+#define EPSILON          1e-9
+#define MAX_LINE_BYTES   4096
+#define MAX_CACHED_TURNS 3
+#define MAX_THREADS      64
+
+typedef struct
+{
+    int num_turns;
+    Code_t guesses[MM_MAX_MAX_GUESSES];
+    Feedback_t feedbacks[MM_MAX_MAX_GUESSES];
+} GameRecord;
+
+typedef struct
+{
+    int num_turns; // Analyzed turns
+    bool solved;
+    bool invalid; // Feedbacks contradict each other
+    int ranks[MM_MAX_MAX_GUESSES];
+    double entropy_lost;
+    double extra_turns;
+} GameStats;
+
+typedef struct
+{
+    bool ready;
+    double *sorted_scores; // Entropy score of each code, ascending (best first)
+} Transposition;
+
+typedef struct
+{
+    RecPosition position;
+    Code_t guess;
+} PartitionKey;
+
+typedef struct
+{
+    CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+} PartitionEntry;
+
+typedef struct
+{
+    MM_Context *ctx;
+    GameRecord *games;
+    GameStats *stats;
+    int num_games;
+    int next_game;
+
+    // Shared caches, protected by mutex
+    HashMap transpositions;
+    HashMap partitions;
+    Vector score_arrays; // Owned by transpositions
+    uint64_t num_hits;
+    uint64_t num_misses;
+    pthread_mutex_t mutex;
+    pthread_cond_t computed;
+} Analyzer;
+
+typedef struct
+{
+    Analyzer *analyzer;
+    const Code_t *solutions;
+    CodeSize_t num_sols;
+    Code_t first;
+    Code_t last;
+    double *out_scores;
+} ScoreJob;
+
+static void get_partition_counts(MM_Context *ctx, Code_t guess, const Code_t *solutions, CodeSize_t num_sols, CodeSize_t *out_counts)
+{
+    if (num_sols == mm_get_num_codes(ctx))
+    {
+        mm_get_partition_range(ctx, guess, 0, num_sols, out_counts);
+    }
+    else
+    {
+        mm_get_partition(ctx, guess, solutions, num_sols, out_counts);
+    }
+}
+
+static void *score_guesses(void *arg)
+{
+    ScoreJob *job   = arg;
+    MM_Context *ctx = job->analyzer->ctx;
+    for (Code_t guess = job->first; guess < job->last; guess++)
+    {
+        CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+        get_partition_counts(ctx, guess, job->solutions, job->num_sols, counts);
+        job->out_scores[guess] = rec_score_partition(REC_ENTROPY, job->num_sols, mm_get_num_feedbacks(ctx), counts);
+    }
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Sorted scores of all guesses, code range is split between num_threads threads
+static double *get_sorted_scores(Analyzer *analyzer, const Code_t *solutions, CodeSize_t num_sols, int num_threads)
+{
+    CodeSize_t num_codes = mm_get_num_codes(analyzer->ctx);
+    double *result       = malloc(num_codes * sizeof(double));
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS] = { false };
+    ScoreJob jobs[MAX_THREADS];
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        jobs[i] = (ScoreJob){ .analyzer   = analyzer,
+                              .solutions  = solutions,
+                              .num_sols   = num_sols,
+                              .first      = (uint64_t)num_codes * i / num_threads,
+                              .last       = (uint64_t)num_codes * (i + 1) / num_threads,
+                              .out_scores = result };
+        if (i != 0)
+        {
+            started[i] = (pthread_create(&threads[i], NULL, score_guesses, &jobs[i]) == 0);
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        // First job and those out of threads run on this one
+        if (!started[i])
+        {
+            score_guesses(&jobs[i]);
+        }
+    }
+    for (int i = 1; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    qsort(result, num_codes, sizeof(double), compare_doubles);
+    return result;
+}
+
+/*
+ * Summary: Looks up sorted scores of position in transposition cache or calculates them.
+ *     If another thread is calculating them, waits for it.
+ * Returns: Scores, to be freed by caller if out_owned is set
+ */
+static const double *get_transposition(Analyzer *analyzer,
+                                       const RecPosition *position,
+                                       const Code_t *solutions,
+                                       CodeSize_t num_sols,
+                                       int num_threads,
+                                       bool *out_owned)
+{
+    *out_owned = (position->num_turns >= MAX_CACHED_TURNS);
+    if (*out_owned)
+    {
+        return get_sorted_scores(analyzer, solutions, num_sols, num_threads);
+    }
+
+    pthread_mutex_lock(&analyzer->mutex);
+    bool inserted;
+    Transposition *entry = hm_put(&analyzer->transpositions, position, &inserted);
+    if (!inserted)
+    {
+        analyzer->num_hits++;
+        while (!entry->ready)
+        {
+            pthread_cond_wait(&analyzer->computed, &analyzer->mutex);
+            entry = hm_get(&analyzer->transpositions, position); // Map might have grown
+        }
+        const double *result = entry->sorted_scores;
+        pthread_mutex_unlock(&analyzer->mutex);
+        return result;
+    }
+    analyzer->num_misses++;
+    pthread_mutex_unlock(&analyzer->mutex);
+
+    double *result = get_sorted_scores(analyzer, solutions, num_sols, num_threads);
+
+    pthread_mutex_lock(&analyzer->mutex);
+    entry                = hm_get(&analyzer->transpositions, position);
+    entry->sorted_scores = result;
+    entry->ready         = true;
+    VEC_PUSH_ELEM(&analyzer->score_arrays, double *, result);
+    pthread_cond_broadcast(&analyzer->computed);
+    pthread_mutex_unlock(&analyzer->mutex);
+    return result;
+}
+
+static void get_partition(Analyzer *analyzer,
+                          const RecPosition *position,
+                          Code_t guess,
+                          const Code_t *solutions,
+                          CodeSize_t num_sols,
+                          CodeSize_t *out_counts)
+{
+    PartitionKey key;
+    memset(&key, 0, sizeof(PartitionKey));
+    key.position = *position;
+    key.guess    = guess;
+
+    if (position->num_turns < MAX_CACHED_TURNS)
+    {
+        pthread_mutex_lock(&analyzer->mutex);
+        PartitionEntry *entry = hm_get(&analyzer->partitions, &key);
+        if (entry != NULL)
+        {
+            memcpy(out_counts, entry->counts, sizeof(entry->counts));
+            pthread_mutex_unlock(&analyzer->mutex);
+            return;
+        }
+        pthread_mutex_unlock(&analyzer->mutex);
+    }
+
+    get_partition_counts(analyzer->ctx, guess, solutions, num_sols, out_counts);
+
+    if (position->num_turns < MAX_CACHED_TURNS)
+    {
+        pthread_mutex_lock(&analyzer->mutex);
+        bool inserted;
+        PartitionEntry *entry = hm_put(&analyzer->partitions, &key, &inserted);
+        memcpy(entry->counts, out_counts, sizeof(entry->counts));
+        pthread_mutex_unlock(&analyzer->mutex);
+    }
+}
+
+// Number of scores that are better than score (scores are sorted)
+static CodeSize_t count_better(const double *scores, CodeSize_t num_scores, double score)
+{
+    CodeSize_t low  = 0;
+    CodeSize_t high = num_scores;
+    while (low < high)
+    {
+        CodeSize_t mid = low + (high - low) / 2;
+        if (scores[mid] < score - EPSILON)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void analyze_game(Analyzer *analyzer, const GameRecord *game, GameStats *out_stats)
+{
+    MM_Context *ctx   = analyzer->ctx;
+    int num_feedbacks = mm_get_num_feedbacks(ctx);
+    MM_Match *match   = mm_new_match(ctx, true);
+    Code_t *solutions = malloc(mm_get_num_codes(ctx) * sizeof(Code_t));
+    *out_stats        = (GameStats){ 0 };
+
+    for (int i = 0; i < game->num_turns; i++)
+    {
+        Code_t guess        = game->guesses[i];
+        CodeSize_t num_sols = mm_get_solutions(match, solutions);
+        double lost         = 0;
+        double extra        = 0;
+
+        if (num_sols == 1)
+        {
+            // Anything but the solution costs a turn
+            out_stats->ranks[i] = (guess == solutions[0]) ? 1 : 2;
+            extra               = (guess == solutions[0]) ? 0 : 1;
+        }
+        else
+        {
+            RecPosition position;
+            CodeSize_t counts[MM_MAX_NUM_FEEDBACKS];
+            bool owned;
+            rec_get_position(match, &position);
+            const double *scores = get_transposition(analyzer, &position, solutions, num_sols, 1, &owned);
+            get_partition(analyzer, &position, guess, solutions, num_sols, counts);
+
+            double score        = rec_score_partition(REC_ENTROPY, num_sols, num_feedbacks, counts);
+            double best_bits    = -scores[0];
+            out_stats->ranks[i] = 1 + count_better(scores, mm_get_num_codes(ctx), score);
+            lost                = (score - scores[0] > 0) ? score - scores[0] : 0;
+            extra               = (best_bits > EPSILON) ? lost / best_bits : 0;
+            if (owned)
+            {
+                free((double *)scores);
+            }
+        }
+
+        out_stats->entropy_lost += lost;
+        out_stats->extra_turns  += extra;
+        out_stats->num_turns++;
+
+        mm_constrain(match, guess, game->feedbacks[i]);
+        if (mm_get_remaining_solutions(match) == 0)
+        {
+            out_stats->invalid = true;
+            break;
+        }
+        if (mm_is_winning_feedback(ctx, game->feedbacks[i]))
+        {
+            out_stats->solved = true;
+            break;
+        }
+    }
+
+    free(solutions);
+    mm_free_match(match);
+}
+
+static void *run_worker(void *arg)
+{
+    Analyzer *analyzer = arg;
+    while (true)
+    {
+        pthread_mutex_lock(&analyzer->mutex);
+        int index = analyzer->next_game++;
+        pthread_mutex_unlock(&analyzer->mutex);
+        if (index >= analyzer->num_games)
+        {
+            return NULL;
+        }
+        analyze_game(analyzer, &analyzer->games[index], &analyzer->stats[index]);
+    }
+}
+
+static int parse_hex(char c)
+{
+    if (isdigit((unsigned char)c))
+    {
+        return c - '0';
+    }
+    if ((tolower((unsigned char)c) >= 'a') && (tolower((unsigned char)c) <= 'f'))
+    {
+        return tolower((unsigned char)c) - 'a' + 10;
+    }
+    return -1;
+}
+
+static bool parse_game(MM_Context *ctx, char *line, GameRecord *out_game)
+{
+    int num_slots  = mm_get_num_slots(ctx);
+    int num_colors = mm_get_num_colors(ctx);
+    *out_game      = (GameRecord){ 0 };
+
+    for (char *token = strtok(line, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n"))
+    {
+        if (((int)strlen(token) != num_slots + 3) || (token[num_slots] != ':')
+            || (out_game->num_turns == mm_get_max_guesses(ctx)))
+        {
+            return false;
+        }
+        int colors[MM_MAX_NUM_SLOTS];
+        for (int i = 0; i < num_slots; i++)
+        {
+            colors[i] = parse_hex(token[i]);
+            if ((colors[i] < 0) || (colors[i] >= num_colors))
+            {
+                return false;
+            }
+        }
+        int b = parse_hex(token[num_slots + 1]);
+        int w = parse_hex(token[num_slots + 2]);
+        if ((b < 0) || (w < 0) || (b + w > num_slots) || ((b == num_slots - 1) && (w == 1)))
+        {
+            return false;
+        }
+        out_game->guesses[out_game->num_turns]   = mm_colors_to_code(ctx, colors);
+        out_game->feedbacks[out_game->num_turns] = mm_feedback_to_code(ctx, b, w);
+        out_game->num_turns++;
+    }
+    return out_game->num_turns > 0;
+}
+
+// Returns context of the file header, NULL on error
+static MM_Context *read_games(FILE *file, Vector *out_games)
+{
+    char line[MAX_LINE_BYTES];
+    MM_Context *ctx = NULL;
+    int line_number = 0;
+
+    while (fgets(line, MAX_LINE_BYTES, file) != NULL)
+    {
+        line_number++;
+        if ((line[0] == '#') || (strspn(line, " \t\r\n") == strlen(line)))
+        {
+            continue;
+        }
+        if (ctx == NULL)
+        {
+            int num_slots, num_colors, max_guesses;
+            if ((sscanf(line, "%d %d %d", &num_slots, &num_colors, &max_guesses) != 3)
+                || ((ctx = mm_new_ctx(max_guesses, num_slots, num_colors)) == NULL))
+            {
+                fprintf(stderr, "Invalid header in line %d.\n", line_number);
+                return NULL;
+            }
+            continue;
+        }
+        GameRecord game;
+        if (parse_game(ctx, line, &game))
+        {
+            VEC_PUSH_ELEM(out_games, GameRecord, game);
+        }
+        else
+        {
+            fprintf(stderr, "Skipping invalid game in line %d.\n", line_number);
+        }
+    }
+    if (ctx == NULL)
+    {
+        fprintf(stderr, "Missing header.\n");
+    }
+    return ctx;
+}
+
+static void print_game(int index, const GameStats *stats)
+{
+    printf("game %d: %d turns, %s, ranks", index + 1, stats->num_turns, stats->invalid ? "invalid" : (stats->solved ? "solved" : "unsolved"));
+    for (int i = 0; i < stats->num_turns; i++)
+    {
+        printf(" %d", stats->ranks[i]);
+    }
+    printf(", entropy lost %.3f bits, expected extra turns %.3f\n", stats->entropy_lost, stats->extra_turns);
+}
+
+/*
+ * Summary: Analyzes all games of record file on num_threads threads (<= 0: one per core),
+ *     prints statistics per game and in aggregate
+ * Returns: Exit code
+ */
+int run_analyzer(const char *path, int num_threads)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open %s.\n", path);
+        return 1;
+    }
+    Vector games    = vec_create(sizeof(GameRecord), 64);
+    MM_Context *ctx = read_games(file, &games);
+    fclose(file);
+    if (ctx == NULL)
+    {
+        vec_destroy(&games);
+        return 1;
+    }
+    if (!mm_is_enumerable(ctx))
+    {
+        fprintf(stderr, "Code space too large for analysis.\n");
+        vec_destroy(&games);
+        mm_free_ctx(ctx);
+        return 1;
+    }
+
+    if (num_threads <= 0)
+    {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    num_threads = (num_threads < 1) ? 1 : ((num_threads > MAX_THREADS) ? MAX_THREADS : num_threads);
+
+    Analyzer analyzer = { .ctx            = ctx,
+                          .games          = games.buffer,
+                          .num_games      = vec_count(&games),
+                          .stats          = malloc(vec_count(&games) * sizeof(GameStats)),
+                          .transpositions = hm_create(sizeof(RecPosition), sizeof(Transposition)),
+                          .partitions     = hm_create(sizeof(PartitionKey), sizeof(PartitionEntry)),
+                          .score_arrays   = vec_create(sizeof(double *), 16) };
+    pthread_mutex_init(&analyzer.mutex, NULL);
+    pthread_cond_init(&analyzer.computed, NULL);
+    uint64_t start = timer_now_us();
+
+    // Every game starts in the same position, its scores are calculated by all threads
+    MM_Match *match   = mm_new_match(ctx, true);
+    Code_t *solutions = malloc(mm_get_num_codes(ctx) * sizeof(Code_t));
+    CodeSize_t num    = mm_get_solutions(match, solutions);
+    RecPosition position;
+    bool owned;
+    rec_get_position(match, &position);
+    get_transposition(&analyzer, &position, solutions, num, num_threads, &owned);
+    free(solutions);
+    mm_free_match(match);
+
+    // Workers take games from a shared index, so one out of threads simply runs on this one
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+    for (int i = 0; i < num_threads; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, run_worker, &analyzer) == 0);
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (!started[i])
+        {
+            run_worker(&analyzer);
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    uint64_t elapsed_us = timer_now_us() - start;
+
+    int num_solved       = 0;
+    int num_invalid      = 0;
+    int num_optimal      = 0;
+    long total_turns     = 0;
+    long total_rank      = 0;
+    double total_lost    = 0;
+    double total_extra   = 0;
+    long total_solved_at = 0;
+    for (int i = 0; i < analyzer.num_games; i++)
+    {
+        const GameStats *stats = &analyzer.stats[i];
+        print_game(i, stats);
+        num_solved      += stats->solved;
+        num_invalid     += stats->invalid;
+        total_turns     += stats->num_turns;
+        total_lost      += stats->entropy_lost;
+        total_extra     += stats->extra_turns;
+        total_solved_at += stats->solved ? stats->num_turns : 0;
+        for (int j = 0; j < stats->num_turns; j++)
+        {
+            total_rank  += stats->ranks[j];
+            num_optimal += (stats->ranks[j] == 1);
+        }
+    }
+
+    printf("\n%d games (%d solved, %d invalid), %ld turns analyzed in %.2f s on %d threads\n",
+           analyzer.num_games,
+           num_solved,
+           num_invalid,
+           total_turns,
+           elapsed_us / 1e6,
+           num_threads);
+    if (total_turns > 0)
+    {
+        printf("Average turns to solve:        %.3f\n", (num_solved > 0) ? (double)total_solved_at / num_solved : 0);
+        printf("Optimal guesses:               %.1f%%\n", 100.0 * num_optimal / total_turns);
+        printf("Average rank:                  %.2f\n", (double)total_rank / total_turns);
+        printf("Average entropy lost per turn: %.3f bits\n", total_lost / total_turns);
+        printf("Expected extra turns per game: %.3f\n", total_extra / analyzer.num_games);
+    }
+    printf("Transposition cache: %" PRIu64 " hits, %" PRIu64 " misses\n", analyzer.num_hits, analyzer.num_misses);
+
+    for (size_t i = 0; i < vec_count(&analyzer.score_arrays); i++)
+    {
+        free(*(double **)vec_get(&analyzer.score_arrays, i));
+    }
+    vec_destroy(&analyzer.score_arrays);
+    hm_destroy(&analyzer.transpositions);
+    hm_destroy(&analyzer.partitions);
+    pthread_mutex_destroy(&analyzer.mutex);
+    pthread_cond_destroy(&analyzer.computed);
+    free(analyzer.stats);
+    vec_destroy(&games);
+    mm_free_ctx(ctx);
+    return 0;
+}
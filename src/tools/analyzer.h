@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+ * Game record file: The first line holds number of slots, number of colors and max guesses,
+ * each following line is a game of tokens "GUESS:BW" separated by spaces, e.g. "0012:11".
+ * Colors of the guess (slot 0 first) and blacks and whites are hex digits. Lines starting with '#' are ignored.
+ */
+
+int run_analyzer(const char *path, int num_threads);
@@ -0,0 +1,198 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "simulate.h"
+#include "../mastermind.h"
+#include "../strategy.h"
+#include "../util/table.h"
+
+/*
+ * Head-to-head arena: Built-in strategies and plugins play the same secrets one strategy after another,
+ * each one sharded across all threads. Reports guesses needed, latency percentiles of single moves and
+ * peak heap growth while playing.
+ */
+
+#define MAX_STRATEGIES 32
+
+typedef struct
+{
+    int max_guesses;
+    int num_slots;
+    int num_colors;
+    int rules;
+    CodeSize_t max_samples;
+    int num_threads;
+    int num_strategies;
+    const Strategy *strategies[MAX_STRATEGIES];
+} ArenaOptions;
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted values
+static uint64_t get_percentile(const uint64_t *sorted, size_t num_values, int percent)
+{
+    size_t rank = (num_values * percent + 99) / 100;
+    return (rank == 0) ? 0 : sorted[rank - 1];
+}
+
+static bool parse_options(int argc, char **argv, ArenaOptions *out_options)
+{
+    *out_options = (ArenaOptions){ .max_guesses = 10, .num_slots = 4, .num_colors = 6 };
+    for (int i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--", 2) != 0)
+        {
+            const Strategy *strategy = strat_find(argv[i]);
+            if ((strategy == NULL) || (out_options->num_strategies == MAX_STRATEGIES))
+            {
+                return false;
+            }
+            out_options->strategies[out_options->num_strategies++] = strategy;
+            continue;
+        }
+        if (i + 1 == argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--slots") == 0)
+        {
+            out_options->num_slots = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--colors") == 0)
+        {
+            out_options->num_colors = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--rules") == 0)
+        {
+            out_options->rules = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--guesses") == 0)
+        {
+            out_options->max_guesses = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--samples") == 0)
+        {
+            out_options->max_samples = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i - 1], "--threads") == 0)
+        {
+            out_options->num_threads = atoi(value);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // No strategy given: All built-in ones
+    for (int i = 0; (out_options->num_strategies == 0) && (i < strat_get_num_builtins()); i++)
+    {
+        out_options->strategies[i] = strat_get_builtin(i);
+    }
+    if (out_options->num_strategies == 0)
+    {
+        out_options->num_strategies = strat_get_num_builtins();
+    }
+    return true;
+}
+
+static void print_usage()
+{
+    printf("Usage: --arena [--slots n] [--colors n] [--rules n] [--guesses n] [--samples n] [--threads n] [strategy or ./plugin.so ...]\n");
+    printf("Strategies:");
+    for (int i = 0; i < strat_get_num_builtins(); i++)
+    {
+        printf(" %s", strat_get_builtin(i)->name);
+    }
+    printf("\nPlugins export \"%s\" for ABI version %d, see strategy.h\n", STRAT_ENTRY_SYMBOL, STRAT_ABI_VERSION);
+}
+
+static void add_result_row(Table *tbl, const Strategy *strategy, SimResult *result)
+{
+    int worst;
+    double average        = sim_get_average(result, &worst);
+    size_t num_moves      = vec_count(&result->latencies_us);
+    uint64_t *latencies   = result->latencies_us.buffer;
+    uint64_t num_unsolved = result->histogram[MM_MAX_MAX_GUESSES + 1];
+    qsort(latencies, num_moves, sizeof(uint64_t), compare_u64);
+
+    tbl_add_cell_fmt(tbl, " %s ", strategy->name);
+    tbl_add_cell_fmt(tbl, " %.4f ", average);
+    if (num_unsolved != 0)
+    {
+        tbl_add_cell_fmt(tbl, " %d (%" PRIu64 " unsolved) ", worst, num_unsolved);
+    }
+    else
+    {
+        tbl_add_cell_fmt(tbl, " %d ", worst);
+    }
+    tbl_add_cell_fmt(tbl, " %.3f ", get_percentile(latencies, num_moves, 50) / 1000.0);
+    tbl_add_cell_fmt(tbl, " %.3f ", get_percentile(latencies, num_moves, 90) / 1000.0);
+    tbl_add_cell_fmt(tbl, " %.3f ", get_percentile(latencies, num_moves, 99) / 1000.0);
+    tbl_add_cell_fmt(tbl, " %.3f ", get_percentile(latencies, num_moves, 100) / 1000.0);
+    tbl_add_cell_fmt(tbl, " %.1f ", result->peak_heap / 1024.0);
+    tbl_add_cell_fmt(tbl, " %.2f ", result->elapsed_us / 1e6);
+    tbl_next_row(tbl);
+}
+
+/*
+ * Summary: Plays all given strategies against the same secrets and prints a comparison
+ * Returns: Exit code
+ */
+int run_arena(int argc, char **argv)
+{
+    ArenaOptions options;
+    MM_Context *ctx;
+    if (!parse_options(argc, argv, &options))
+    {
+        print_usage();
+        return 1;
+    }
+    if ((ctx = mm_new_ctx_rules(options.max_guesses, options.num_slots, options.num_colors, options.rules)) == NULL)
+    {
+        printf("Invalid configuration.\n");
+        return 1;
+    }
+
+    int num_threads = sim_get_num_threads(options.num_threads);
+    mm_init_feedback_lookup(ctx); // Before threads start, context is read-only afterwards
+
+    CodeSize_t num_secrets;
+    Code_t *secrets = sim_get_secrets(ctx, options.max_samples, &num_secrets);
+    printf("%d slots, %d colors, %" PRIu64 " secrets%s, %d threads\n",
+           options.num_slots,
+           options.num_colors,
+           (uint64_t)num_secrets,
+           (num_secrets == mm_get_num_codes(ctx)) ? " (all)" : " (sampled)",
+           num_threads);
+
+    Table *tbl = tbl_get_new();
+    tbl_add_cells(tbl, 9, " Strategy ", " Average ", " Worst ", " p50 ms ", " p90 ms ", " p99 ms ", " Max ms ", " Heap KiB ", " Total s ");
+    tbl_next_row(tbl);
+    tbl_set_hline(tbl, TBL_BORDER_SINGLE);
+    for (int i = 0; i < options.num_strategies; i++)
+    {
+        SimResult result;
+        sim_play(ctx, options.strategies[i], secrets, num_secrets, num_threads, true, &result);
+        add_result_row(tbl, options.strategies[i], &result);
+        vec_destroy(&result.latencies_us);
+        printf("%s done\n", options.strategies[i]->name);
+    }
+    tbl_make_boxed(tbl, TBL_BORDER_SINGLE);
+    tbl_set_alternative_style(tbl);
+    tbl_print(tbl);
+    tbl_free(tbl);
+
+    free(secrets);
+    mm_free_ctx(ctx);
+    return 0;
+}
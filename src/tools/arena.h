@@ -0,0 +1,3 @@
+#pragma once
+
+int run_arena(int argc, char **argv);
@@ -0,0 +1,410 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../feedback_table.h"
+#include "../multi_board.h"
+#include "../util/timer.h"
+
+#define NUM_GUESSES     8
+#define NUM_MATCHES     64
+#define NUM_BOARD_GAMES 16
+#define NUM_BOARDS      4
+#define MAX_BRUTE_FORCE (1u << 22) // Codes times tuples of secrets up to which joint partitions are enumerated
+#define EPSILON         1e-9
+
+static double ns_per_code(uint64_t elapsed_us, CodeSize_t num_codes)
+{
+    return 1000.0 * elapsed_us / ((double)num_codes * NUM_GUESSES);
+}
+
+// Constrains NUM_MATCHES matches with random secrets one by one and as batch, returns false if results differ
+static bool bench_constrain(MM_Context *ctx, uint64_t *out_single_us, uint64_t *out_batch_us)
+{
+    MM_Match *single[NUM_MATCHES];
+    MM_ConstrainRequest requests[NUM_MATCHES];
+    Code_t guess = mm_get_random_code(ctx);
+    bool equal   = true;
+
+    for (int i = 0; i < NUM_MATCHES; i++)
+    {
+        Code_t secret = mm_get_random_code(ctx);
+        single[i]     = mm_new_match(ctx, true);
+        requests[i]   = (MM_ConstrainRequest){ .match    = mm_new_match(ctx, true),
+                                               .guess    = guess,
+                                               .feedback = mm_get_feedback(ctx, guess, secret) };
+    }
+
+    uint64_t start = timer_now_us();
+    for (int i = 0; i < NUM_MATCHES; i++)
+    {
+        mm_constrain(single[i], requests[i].guess, requests[i].feedback);
+    }
+    *out_single_us = timer_now_us() - start;
+
+    start = timer_now_us();
+    mm_constrain_batch(ctx, requests, NUM_MATCHES);
+    *out_batch_us = timer_now_us() - start;
+
+    for (int i = 0; i < NUM_MATCHES; i++)
+    {
+        equal &= (mm_get_remaining_solutions(single[i]) == mm_get_remaining_solutions(requests[i].match));
+        mm_free_match(single[i]);
+        mm_free_match(requests[i].match);
+    }
+    return equal;
+}
+
+/*
+ * Summary: Plays NUM_BOARD_GAMES games on NUM_BOARDS boards with random guesses, once as multi-board match
+ *     (one shared sweep per guess) and once as independent matches
+ * Returns: false if the solution spaces differ
+ */
+static bool bench_multi_board(MM_Context *ctx, uint64_t *out_independent_us, uint64_t *out_shared_us)
+{
+    bool equal          = true;
+    *out_independent_us = 0;
+    *out_shared_us      = 0;
+    for (int i = 0; i < NUM_BOARD_GAMES; i++)
+    {
+        MultiMatch *shared = mb_new_match(ctx, NUM_BOARDS);
+        MM_Match *independent[NUM_BOARDS];
+        Code_t secrets[NUM_BOARDS];
+        for (int j = 0; j < NUM_BOARDS; j++)
+        {
+            independent[j] = mm_new_match(ctx, true);
+            secrets[j]     = mm_get_random_code(ctx);
+        }
+
+        for (int turn = 0; (turn < NUM_GUESSES) && (mb_get_state(shared) == MM_MATCH_PENDING); turn++)
+        {
+            Code_t guess = mm_get_random_code(ctx);
+            Feedback_t feedbacks[NUM_BOARDS];
+            for (int j = 0; j < NUM_BOARDS; j++)
+            {
+                feedbacks[j] = mm_get_feedback(ctx, guess, secrets[j]);
+            }
+
+            uint64_t start = timer_now_us();
+            for (int j = 0; j < NUM_BOARDS; j++)
+            {
+                if (mm_get_state(independent[j]) == MM_MATCH_PENDING)
+                {
+                    mm_constrain(independent[j], guess, feedbacks[j]);
+                }
+            }
+            *out_independent_us += timer_now_us() - start;
+
+            start = timer_now_us();
+            mb_constrain(shared, guess, feedbacks);
+            *out_shared_us += timer_now_us() - start;
+        }
+
+        for (int j = 0; j < NUM_BOARDS; j++)
+        {
+            equal &= (mm_get_remaining_solutions(independent[j]) == mm_get_remaining_solutions(mb_get_board(shared, j)));
+            mm_free_match(independent[j]);
+        }
+        mb_free_match(shared);
+    }
+    return equal;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Summary: Negative entropy of the joint partition of guess by brute force: Every tuple of remaining solutions
+ *     of the pending boards is keyed by its vector of feedbacks, keys are sorted and counted
+ */
+static double get_joint_score(MultiMatch *match, Code_t guess, Code_t **solutions, const CodeSize_t *num_sols, uint64_t *keys)
+{
+    MM_Context *ctx       = mb_get_context(match);
+    int num_boards        = mb_get_num_boards(match);
+    CodeSize_t num_tuples = 1;
+    for (int j = 0; j < num_boards; j++)
+    {
+        num_tuples *= num_sols[j];
+    }
+
+    CodeSize_t digits[NUM_BOARDS] = { 0 };
+    for (CodeSize_t t = 0; t < num_tuples; t++)
+    {
+        uint64_t key = 0;
+        for (int j = 0; j < num_boards; j++)
+        {
+            key = key * mm_get_num_feedbacks(ctx) + mm_get_feedback(ctx, guess, solutions[j][digits[j]]);
+        }
+        keys[t] = key;
+        for (int j = 0; (j < num_boards) && (++digits[j] == num_sols[j]); j++)
+        {
+            digits[j] = 0;
+        }
+    }
+    qsort(keys, num_tuples, sizeof(uint64_t), compare_u64);
+
+    double result = 0;
+    for (CodeSize_t first = 0, next = 0; first < num_tuples; first = next)
+    {
+        while ((next < num_tuples) && (keys[next] == keys[first]))
+        {
+            next++;
+        }
+        double p = (double)(next - first) / num_tuples;
+        result  += p * log2(p);
+    }
+    return result;
+}
+
+/*
+ * Summary: Plays NUM_BOARD_GAMES games on NUM_BOARDS boards with mb_recommend. Each move is checked:
+ *     If a board has a single solution left, it must be guessed. Otherwise, while the enumeration is small,
+ *     no code may split the tuples of remaining secrets better than the recommended guess.
+ * Returns: false if a move fails its check or a game is lost
+ */
+static bool bench_multi_board_recommend(MM_Context *ctx, uint64_t *out_us, int *out_num_moves, int *out_num_singles, int *out_num_checked)
+{
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    bool valid           = true;
+    *out_us              = 0;
+    *out_num_moves       = 0;
+    *out_num_singles     = 0;
+    *out_num_checked     = 0;
+    for (int i = 0; i < NUM_BOARD_GAMES; i++)
+    {
+        MultiMatch *match = mb_new_match(ctx, NUM_BOARDS);
+        Code_t secrets[NUM_BOARDS];
+        for (int j = 0; j < NUM_BOARDS; j++)
+        {
+            secrets[j] = mm_get_random_code(ctx);
+        }
+
+        while (mb_get_state(match) == MM_MATCH_PENDING)
+        {
+            uint64_t start = timer_now_us();
+            Code_t guess   = mb_recommend(match, 0);
+            *out_us       += timer_now_us() - start;
+            (*out_num_moves)++;
+
+            Code_t *solutions[NUM_BOARDS];
+            CodeSize_t num_sols[NUM_BOARDS];
+            CodeSize_t num_tuples = 1;
+            bool has_single       = false;
+            bool solves_single    = false;
+            for (int j = 0; j < NUM_BOARDS; j++)
+            {
+                MM_Match *board = mb_get_board(match, j);
+                bool pending    = (mm_get_state(board) == MM_MATCH_PENDING);
+                num_sols[j]     = pending ? mm_get_remaining_solutions(board) : 1;
+                solutions[j]    = malloc(num_sols[j] * sizeof(Code_t));
+                if (pending)
+                {
+                    mm_get_solutions(board, solutions[j]);
+                }
+                else
+                {
+                    solutions[j][0] = mm_get_history_guess(board, mm_get_turns(board) - 1); // Won, feedback is constant
+                }
+                has_single    |= pending && (num_sols[j] == 1);
+                solves_single |= pending && (num_sols[j] == 1) && (solutions[j][0] == guess);
+                num_tuples    *= num_sols[j];
+            }
+
+            if (has_single)
+            {
+                valid &= solves_single;
+                (*out_num_singles)++;
+            }
+            else if ((uint64_t)num_tuples * num_codes <= MAX_BRUTE_FORCE)
+            {
+                uint64_t *keys = malloc(num_tuples * sizeof(uint64_t));
+                double score   = get_joint_score(match, guess, solutions, num_sols, keys);
+                for (Code_t code = 0; code < num_codes; code++)
+                {
+                    valid &= (get_joint_score(match, code, solutions, num_sols, keys) > score - EPSILON);
+                }
+                (*out_num_checked)++;
+                free(keys);
+            }
+            for (int j = 0; j < NUM_BOARDS; j++)
+            {
+                free(solutions[j]);
+            }
+
+            Feedback_t feedbacks[NUM_BOARDS];
+            for (int j = 0; j < NUM_BOARDS; j++)
+            {
+                feedbacks[j] = mm_get_feedback(ctx, guess, secrets[j]);
+            }
+            mb_constrain(match, guess, feedbacks);
+        }
+        valid &= (mb_get_state(match) == MM_MATCH_WON);
+        mb_free_match(match);
+    }
+    return valid;
+}
+
+/*
+ * Summary: Times what the first fast mode game after an options change waits for on a fresh context:
+ *     Pairwise feedback table and feedback statistics. Statistics are compared against a count over the table.
+ * Returns: false if the statistics differ
+ */
+static bool bench_quickie_startup(int num_slots, int num_colors, uint64_t *out_lookup_us, uint64_t *out_stats_us)
+{
+    MM_Context *ctx = mm_new_ctx(MM_MAX_MAX_GUESSES, num_slots, num_colors);
+    uint64_t start  = timer_now_us();
+    bool has_lookup = mm_init_feedback_lookup(ctx);
+    *out_lookup_us  = timer_now_us() - start;
+    *out_stats_us   = 0;
+    if (!has_lookup)
+    {
+        // Fast mode doesn't rank feedbacks without the table
+        mm_free_ctx(ctx);
+        return true;
+    }
+
+    start                         = timer_now_us();
+    const MM_FeedbackStats *stats = mm_get_feedback_stats(ctx);
+    *out_stats_us                 = timer_now_us() - start;
+
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    bool equal           = true;
+    MM_FeedbackStats reference;
+    memset(&reference, 0, sizeof(reference));
+    for (Code_t a = 0; a < num_codes; a++)
+    {
+        bool hit[MM_MAX_NUM_FEEDBACKS] = { false };
+        for (Code_t b = 0; b < num_codes; b++)
+        {
+            Feedback_t fb = mm_get_feedback(ctx, a, b);
+            reference.num_pairs[fb]++;
+            hit[fb] = true;
+        }
+        for (int fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+        {
+            reference.num_hits[fb] += hit[fb];
+        }
+    }
+    for (int fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+    {
+        equal &= (stats->num_pairs[fb] == reference.num_pairs[fb]) && (stats->num_hits[fb] == reference.num_hits[fb]);
+    }
+    mm_free_ctx(ctx);
+    return equal;
+}
+
+/*
+ * Summary: Compares the batched feedback kernel with Gray-order walks over the whole code space,
+ *     both for plain feedbacks and for partition counting, single against batched constraining
+ *     and multi-board matches against independent ones. Closed-form partitions are checked against enumerated ones,
+ *     multi-board recommendations against joint partitions.
+ *     Also times fast mode startup.
+ * Returns: Exit code, 1 if results differ
+ */
+int run_benchmark(int num_slots, int num_colors)
+{
+    MM_Context *ctx = mm_new_ctx(MM_MAX_MAX_GUESSES, num_slots, num_colors);
+    if ((ctx == NULL) || !mm_is_enumerable(ctx))
+    {
+        printf("Code space too large for benchmark.\n");
+        if (ctx != NULL)
+        {
+            mm_free_ctx(ctx);
+        }
+        return 1;
+    }
+
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    Code_t *codes        = malloc(num_codes * sizeof(Code_t));
+    Feedback_t *batched  = malloc(num_codes * sizeof(Feedback_t));
+    Feedback_t *walked   = malloc(num_codes * sizeof(Feedback_t));
+    uint64_t batched_us  = 0;
+    uint64_t walked_us   = 0;
+    uint64_t b_part_us   = 0;
+    uint64_t w_part_us   = 0;
+    uint64_t c_part_us   = 0;
+    bool equal           = true;
+    for (CodeSize_t i = 0; i < num_codes; i++)
+    {
+        codes[i] = i;
+    }
+
+    for (int i = 0; i < NUM_GUESSES; i++)
+    {
+        Code_t guess = mm_get_random_code(ctx);
+        CodeSize_t b_counts[MM_MAX_NUM_FEEDBACKS];
+        CodeSize_t w_counts[MM_MAX_NUM_FEEDBACKS];
+        CodeSize_t c_counts[MM_MAX_NUM_FEEDBACKS];
+
+        uint64_t start = timer_now_us();
+        mm_get_feedbacks(ctx, guess, codes, num_codes, batched);
+        batched_us += timer_now_us() - start;
+
+        start = timer_now_us();
+        mm_get_feedbacks_range(ctx, guess, 0, num_codes, walked);
+        walked_us += timer_now_us() - start;
+
+        start = timer_now_us();
+        mm_get_partition(ctx, guess, codes, num_codes, b_counts);
+        b_part_us += timer_now_us() - start;
+
+        start = timer_now_us();
+        mm_get_partition_range(ctx, guess, 0, num_codes, w_counts);
+        w_part_us += timer_now_us() - start;
+
+        start = timer_now_us();
+        ft_get_partition(ctx, guess, c_counts);
+        c_part_us += timer_now_us() - start;
+
+        for (CodeSize_t j = 0; j < num_codes; j++)
+        {
+            equal &= (batched[j] == walked[j]);
+        }
+        for (int fb = 0; fb < mm_get_num_feedbacks(ctx); fb++)
+        {
+            equal &= (b_counts[fb] == w_counts[fb]) && (c_counts[fb] == w_counts[fb]);
+        }
+    }
+
+    printf("%d slots, %d colors, %" PRIu64 " codes, %d guesses\n", num_slots, num_colors, (uint64_t)num_codes, NUM_GUESSES);
+    printf("Feedbacks, batched:  %7.2f ns/code\n", ns_per_code(batched_us, num_codes));
+    printf("Feedbacks, Gray:     %7.2f ns/code\n", ns_per_code(walked_us, num_codes));
+    printf("Partition, batched:  %7.2f ns/code\n", ns_per_code(b_part_us, num_codes));
+    printf("Partition, Gray:     %7.2f ns/code\n", ns_per_code(w_part_us, num_codes));
+    printf("Partition, closed:   %7.2f us/guess\n", (double)c_part_us / NUM_GUESSES);
+    uint64_t single_us, batch_us;
+    equal &= bench_constrain(ctx, &single_us, &batch_us);
+    printf("Constrain %d matches, single:  %7.2f ms\n", NUM_MATCHES, single_us / 1000.0);
+    printf("Constrain %d matches, batched: %7.2f ms\n", NUM_MATCHES, batch_us / 1000.0);
+    uint64_t independent_us, shared_us;
+    equal &= bench_multi_board(ctx, &independent_us, &shared_us);
+    printf("%d games on %d boards, independent: %7.2f ms\n", NUM_BOARD_GAMES, NUM_BOARDS, independent_us / 1000.0);
+    printf("%d games on %d boards, shared:      %7.2f ms\n", NUM_BOARD_GAMES, NUM_BOARDS, shared_us / 1000.0);
+    uint64_t recommend_us;
+    int num_moves, num_singles, num_checked;
+    equal &= bench_multi_board_recommend(ctx, &recommend_us, &num_moves, &num_singles, &num_checked);
+    printf("%d games on %d boards, recommended: %.2f guesses, %.2f ms/move\n",
+           NUM_BOARD_GAMES,
+           NUM_BOARDS,
+           (double)num_moves / NUM_BOARD_GAMES,
+           recommend_us / 1000.0 / num_moves);
+    printf("Moves checked: %d solved a single solution, %d by joint enumeration, of %d\n", num_singles, num_checked, num_moves);
+    uint64_t lookup_us, stats_us;
+    equal &= bench_quickie_startup(num_slots, num_colors, &lookup_us, &stats_us);
+    printf("Fast mode startup, feedback table:      %7.2f ms\n", lookup_us / 1000.0);
+    printf("Fast mode startup, feedback statistics: %7.2f ms\n", stats_us / 1000.0);
+    printf("Results %s.\n", equal ? "match" : "DIFFER");
+
+    free(codes);
+    free(batched);
+    free(walked);
+    mm_free_ctx(ctx);
+    return equal ? 0 : 1;
+}
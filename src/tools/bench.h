@@ -0,0 +1,4 @@
+#pragma once
+#include "../mastermind.h"
+
+int run_benchmark(int num_slots, int num_colors);
@@ -0,0 +1,218 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzzles.h"
+#include "simulate.h"
+#include "../mastermind.h"
+#include "../quickie.h"
+#include "../util/timer.h"
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+    int max_guesses;
+    int num_slots;
+    int num_colors;
+    int rules;
+    int count;
+    int difficulty;  // 0: All difficulties in turn
+    int num_threads; // <= 0: One per core
+    uint64_t seed;
+    const char *out_path;
+} PuzzleOptions;
+
+typedef struct
+{
+    MM_Context *ctx;
+    const PuzzleOptions *options;
+    int index;
+    int num_threads;
+    QkPuzzle *puzzles;
+} PuzzleWorker;
+
+static bool parse_options(int argc, char **argv, PuzzleOptions *out_options)
+{
+    *out_options = (PuzzleOptions){ .max_guesses = 10, .num_slots = 4, .num_colors = 6, .count = 1000, .seed = rng_get_entropy() };
+    for (int i = 0; i < argc; i++)
+    {
+        if (i + 1 == argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--slots") == 0)
+        {
+            out_options->num_slots = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--colors") == 0)
+        {
+            out_options->num_colors = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--rules") == 0)
+        {
+            out_options->rules = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--guesses") == 0)
+        {
+            out_options->max_guesses = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--count") == 0)
+        {
+            out_options->count = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--difficulty") == 0)
+        {
+            out_options->difficulty = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--threads") == 0)
+        {
+            out_options->num_threads = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--seed") == 0)
+        {
+            out_options->seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i - 1], "--out") == 0)
+        {
+            out_options->out_path = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return (out_options->out_path != NULL) && (out_options->count > 0) && (out_options->difficulty >= 0)
+        && (out_options->difficulty <= QK_NUM_DIFFICULTIES);
+}
+
+// Puzzle i is generated from seed + i, so the file doesn't depend on the number of threads
+static void *run_worker(void *arg)
+{
+    PuzzleWorker *worker = arg;
+    Quickie *quickie     = qk_new(worker->ctx, 0);
+    for (int i = worker->index; i < worker->options->count; i += worker->num_threads)
+    {
+        int difficulty = (worker->options->difficulty != 0) ? worker->options->difficulty : 1 + i % QK_NUM_DIFFICULTIES;
+        qk_set_seed(quickie, worker->options->seed + i);
+        qk_generate(quickie, difficulty, &worker->puzzles[i]);
+    }
+    qk_free(quickie);
+    return NULL;
+}
+
+static void print_hex_code(FILE *file, MM_Context *ctx, Code_t code)
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, code, colors);
+    for (int i = 0; i < mm_get_num_slots(ctx); i++)
+    {
+        fprintf(file, "%x", colors[i]);
+    }
+}
+
+static bool write_puzzles(MM_Context *ctx, int rules, const QkPuzzle *puzzles, int count, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+    fprintf(file, "%d %d %d\n", mm_get_num_slots(ctx), mm_get_num_colors(ctx), rules);
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(file, "%d ", puzzles[i].difficulty);
+        print_hex_code(file, ctx, puzzles[i].solution);
+        fprintf(file, " :");
+        for (int j = 0; j < puzzles[i].num_guesses; j++)
+        {
+            fprintf(file, " ");
+            print_hex_code(file, ctx, puzzles[i].guesses[j]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return true;
+}
+
+/*
+ * Summary: Generates fast mode puzzles on all cores and writes them to a file
+ * Returns: Exit code
+ */
+int run_puzzle_dump(int argc, char **argv)
+{
+    PuzzleOptions options;
+    MM_Context *ctx;
+    if (!parse_options(argc, argv, &options))
+    {
+        printf("Usage: --puzzles --out file [--slots n] [--colors n] [--rules n] [--guesses n] [--count n] [--difficulty 1-%d] "
+               "[--threads n] [--seed n]\n",
+               QK_NUM_DIFFICULTIES);
+        return 1;
+    }
+    if ((ctx = mm_new_ctx_rules(options.max_guesses, options.num_slots, options.num_colors, options.rules)) == NULL)
+    {
+        printf("Invalid configuration.\n");
+        return 1;
+    }
+    if (!qk_prepare_context(ctx)) // Before threads start, context is read-only afterwards
+    {
+        printf("Too many codes for puzzles, at most %d.\n", MM_MAX_LOOKUP_CODES);
+        mm_free_ctx(ctx);
+        return 1;
+    }
+
+    int num_threads   = sim_get_num_threads(options.num_threads);
+    QkPuzzle *puzzles = malloc(options.count * sizeof(QkPuzzle));
+    uint64_t start    = timer_now_us();
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+    PuzzleWorker workers[MAX_THREADS];
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i] = (PuzzleWorker){ .ctx         = ctx,
+                                     .options     = &options,
+                                     .index       = i,
+                                     .num_threads = num_threads,
+                                     .puzzles     = puzzles };
+        started[i] = (pthread_create(&threads[i], NULL, run_worker, &workers[i]) == 0);
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        // Out of threads: The worker's puzzles are generated on this one
+        if (!started[i])
+        {
+            run_worker(&workers[i]);
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    uint64_t elapsed = timer_now_us() - start;
+
+    bool written = write_puzzles(ctx, options.rules, puzzles, options.count, options.out_path);
+    if (written)
+    {
+        printf("%d puzzles written to %s (%.2f s, %.2f ms per puzzle, %d threads, seed %" PRIu64 ").\n",
+               options.count,
+               options.out_path,
+               elapsed / 1e6,
+               elapsed / 1000.0 / options.count,
+               num_threads,
+               options.seed);
+    }
+    else
+    {
+        printf("Can't write %s.\n", options.out_path);
+    }
+    free(puzzles);
+    mm_free_ctx(ctx);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+ * Puzzle file of fast mode: The first line holds number of slots, number of colors and rules, each following line
+ * a puzzle as difficulty, solution and the auto-played guesses, e.g. "2 0123 : 0011 1234". Colors are hex digits
+ * (slot 0 first), as in game records of the analyzer.
+ */
+
+int run_puzzle_dump(int argc, char **argv);
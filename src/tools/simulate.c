@@ -0,0 +1,348 @@
+#define _DEFAULT_SOURCE
+#include <inttypes.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "simulate.h"
+#include "../mastermind.h"
+#include "../strategy.h"
+#include "../util/timer.h"
+#include "../util/vector.h"
+
+/*
+ * Headless simulation: A strategy plays against every secret code (or a random sample of them),
+ * secrets are sharded across threads. Reports distribution of guesses needed, average, worst case
+ * and time per game.
+ */
+
+#define MAX_THREADS     64
+#define DEFAULT_SAMPLES 1000
+
+typedef struct
+{
+    int max_guesses;
+    int num_slots;
+    int num_colors;
+    int rules;
+    CodeSize_t max_samples; // 0: All codes
+    int num_threads;        // <= 0: One per core
+    int expect_max;         // Fail if any game needs more guesses, 0: No expectation
+    bool has_seed;          // Otherwise the context's seed from the clock is kept
+    uint64_t seed;
+    const char *strategy;
+} SimOptions;
+
+typedef struct
+{
+    MM_Context *ctx;
+    const Strategy *strategy;
+    const Code_t *secrets;
+    CodeSize_t num_secrets;
+    int index;
+    int num_threads;
+    bool measure_memory;
+    SimResult result;
+} Shard;
+
+// Bytes allocated on the heap by all threads
+static size_t get_heap_in_use()
+{
+    return mallinfo2().uordblks;
+}
+
+static void *run_shard(void *arg)
+{
+    Shard *shard = arg;
+    void *state  = (shard->strategy->init != NULL) ? shard->strategy->init(shard->ctx) : NULL;
+
+    for (CodeSize_t i = shard->index; i < shard->num_secrets; i += shard->num_threads)
+    {
+        uint64_t start  = timer_now_us();
+        MM_Match *match = mm_new_match(shard->ctx, true);
+        mm_seed_match(match, mm_get_seed(shard->ctx) + i); // Same game for any number of threads
+        while (mm_get_state(match) == MM_MATCH_PENDING)
+        {
+            uint64_t move_start = timer_now_us();
+            Code_t guess        = shard->strategy->choose(state, match);
+            VEC_PUSH_ELEM(&shard->result.latencies_us, uint64_t, timer_now_us() - move_start);
+            if (shard->measure_memory)
+            {
+                size_t heap             = get_heap_in_use();
+                shard->result.peak_heap = (heap > shard->result.peak_heap) ? heap : shard->result.peak_heap;
+            }
+            mm_constrain(match, guess, mm_get_feedback(shard->ctx, guess, shard->secrets[i]));
+        }
+        uint64_t elapsed = timer_now_us() - start;
+
+        shard->result.histogram[(mm_get_state(match) == MM_MATCH_WON) ? mm_get_turns(match) : MM_MAX_MAX_GUESSES + 1]++;
+        shard->result.total_us += elapsed;
+        shard->result.max_us    = (elapsed > shard->result.max_us) ? elapsed : shard->result.max_us;
+        mm_free_match(match);
+    }
+
+    if (shard->strategy->free != NULL)
+    {
+        shard->strategy->free(state);
+    }
+    return NULL;
+}
+
+/*
+ * Summary: Plays strategy against each secret, secrets are sharded across num_threads threads.
+ *     Latency of each move is recorded, peak heap usage only if measure_memory is set.
+ */
+void sim_play(MM_Context *ctx,
+              const Strategy *strategy,
+              const Code_t *secrets,
+              CodeSize_t num_secrets,
+              int num_threads,
+              bool measure_memory,
+              SimResult *out_result)
+{
+    Shard *shards = calloc(num_threads, sizeof(Shard));
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+
+    // Latencies are preallocated, so that they don't count as heap usage of the strategy
+    size_t max_moves = (num_secrets / num_threads + 1) * mm_get_max_guesses(ctx);
+    for (int i = 0; i < num_threads; i++)
+    {
+        shards[i] = (Shard){ .ctx            = ctx,
+                             .strategy       = strategy,
+                             .secrets        = secrets,
+                             .num_secrets    = num_secrets,
+                             .index          = i,
+                             .num_threads    = num_threads,
+                             .measure_memory = measure_memory,
+                             .result         = { .latencies_us = vec_create(sizeof(uint64_t), max_moves) } };
+    }
+
+    size_t heap_before = get_heap_in_use();
+    uint64_t start     = timer_now_us();
+    for (int i = 0; i < num_threads; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, run_shard, &shards[i]) == 0);
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        // Out of threads: The shard is played on this one
+        if (!started[i])
+        {
+            run_shard(&shards[i]);
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    *out_result = (SimResult){ .num_secrets  = num_secrets,
+                               .elapsed_us   = timer_now_us() - start,
+                               .latencies_us = vec_create(sizeof(uint64_t), max_moves * num_threads) };
+    for (int i = 0; i < num_threads; i++)
+    {
+        for (int j = 0; j < MM_MAX_MAX_GUESSES + 2; j++)
+        {
+            out_result->histogram[j] += shards[i].result.histogram[j];
+        }
+        out_result->total_us += shards[i].result.total_us;
+        out_result->max_us   = (shards[i].result.max_us > out_result->max_us) ? shards[i].result.max_us : out_result->max_us;
+        out_result->peak_heap = (shards[i].result.peak_heap > out_result->peak_heap) ? shards[i].result.peak_heap : out_result->peak_heap;
+        vec_push_many(&out_result->latencies_us, vec_count(&shards[i].result.latencies_us), shards[i].result.latencies_us.buffer);
+        vec_destroy(&shards[i].result.latencies_us);
+    }
+    out_result->peak_heap = (out_result->peak_heap > heap_before) ? out_result->peak_heap - heap_before : 0;
+    free(shards);
+}
+
+// All codes if there are at most max_samples (0: no limit), otherwise a random sample
+Code_t *sim_get_secrets(MM_Context *ctx, CodeSize_t max_samples, CodeSize_t *out_num_secrets)
+{
+    CodeSize_t num_codes = mm_get_num_codes(ctx);
+    bool all             = mm_is_enumerable(ctx) && ((max_samples == 0) || (max_samples >= num_codes));
+    if (!all && (max_samples == 0))
+    {
+        max_samples = DEFAULT_SAMPLES;
+    }
+
+    *out_num_secrets = all ? num_codes : max_samples;
+    Code_t *result   = malloc(*out_num_secrets * sizeof(Code_t));
+    for (CodeSize_t i = 0; i < *out_num_secrets; i++)
+    {
+        result[i] = all ? i : mm_get_random_code(ctx);
+    }
+    return result;
+}
+
+// Clamps number of threads, <= 0: One per core
+int sim_get_num_threads(int num_threads)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    return (num_threads < 1) ? 1 : ((num_threads > MAX_THREADS) ? MAX_THREADS : num_threads);
+}
+
+// Average number of guesses of solved games, worst case (0 if none was solved)
+double sim_get_average(const SimResult *result, int *out_worst)
+{
+    uint64_t total_guesses = 0;
+    uint64_t num_solved    = 0;
+    *out_worst             = 0;
+    for (int i = 1; i <= MM_MAX_MAX_GUESSES; i++)
+    {
+        if (result->histogram[i] != 0)
+        {
+            total_guesses += i * result->histogram[i];
+            num_solved    += result->histogram[i];
+            *out_worst     = i;
+        }
+    }
+    return (num_solved != 0) ? (double)total_guesses / num_solved : 0;
+}
+
+static bool parse_options(int argc, char **argv, SimOptions *out_options)
+{
+    *out_options = (SimOptions){ .max_guesses = 10, .num_slots = 4, .num_colors = 6, .strategy = "knuth" };
+    for (int i = 0; i < argc; i++)
+    {
+        if (i + 1 == argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--strategy") == 0)
+        {
+            out_options->strategy = value;
+        }
+        else if (strcmp(argv[i - 1], "--slots") == 0)
+        {
+            out_options->num_slots = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--colors") == 0)
+        {
+            out_options->num_colors = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--rules") == 0)
+        {
+            out_options->rules = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--guesses") == 0)
+        {
+            out_options->max_guesses = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--samples") == 0)
+        {
+            out_options->max_samples = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i - 1], "--threads") == 0)
+        {
+            out_options->num_threads = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--expect-max") == 0)
+        {
+            out_options->expect_max = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--seed") == 0)
+        {
+            out_options->has_seed = true;
+            out_options->seed     = strtoull(value, NULL, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_usage()
+{
+    printf("Usage: --simulate [--strategy name] [--slots n] [--colors n] [--rules n] [--guesses n] [--samples n] [--threads n] [--expect-max n] [--seed n]\n");
+    printf("Strategies:");
+    for (int i = 0; i < strat_get_num_builtins(); i++)
+    {
+        printf(" %s", strat_get_builtin(i)->name);
+    }
+    printf("\n");
+}
+
+/*
+ * Summary: Plays strategy against all or sampled secrets and prints distribution of number of guesses
+ * Returns: Exit code, 1 if --expect-max is given and a game needed more guesses or wasn't solved
+ */
+int run_simulation(int argc, char **argv)
+{
+    SimOptions options;
+    const Strategy *strategy;
+    MM_Context *ctx;
+    if (!parse_options(argc, argv, &options) || ((strategy = strat_find(options.strategy)) == NULL))
+    {
+        print_usage();
+        return 1;
+    }
+    if ((ctx = mm_new_ctx_rules(options.max_guesses, options.num_slots, options.num_colors, options.rules)) == NULL)
+    {
+        printf("Invalid configuration.\n");
+        return 1;
+    }
+
+    if (options.has_seed)
+    {
+        mm_seed(ctx, options.seed);
+    }
+    int num_threads = sim_get_num_threads(options.num_threads);
+    mm_init_feedback_lookup(ctx); // Before threads start, context is read-only afterwards
+
+    CodeSize_t num_secrets;
+    Code_t *secrets = sim_get_secrets(ctx, options.max_samples, &num_secrets);
+    SimResult result;
+    sim_play(ctx, strategy, secrets, num_secrets, num_threads, false, &result);
+
+    int worst;
+    double average = sim_get_average(&result, &worst);
+    printf("Strategy %s, %d slots, %d colors, %" PRIu64 " secrets%s, %d threads, seed %" PRIu64 "\n",
+           strategy->name,
+           options.num_slots,
+           options.num_colors,
+           (uint64_t)num_secrets,
+           (num_secrets == mm_get_num_codes(ctx)) ? " (all)" : " (sampled)",
+           num_threads,
+           mm_get_seed(ctx));
+    for (int i = 1; i <= MM_MAX_MAX_GUESSES; i++)
+    {
+        if (result.histogram[i] != 0)
+        {
+            printf("%2d guesses: %8" PRIu64 " (%5.2f%%)\n", i, result.histogram[i], 100.0 * result.histogram[i] / num_secrets);
+        }
+    }
+    uint64_t num_unsolved = result.histogram[MM_MAX_MAX_GUESSES + 1];
+    if (num_unsolved != 0)
+    {
+        printf("  unsolved: %8" PRIu64 " (%5.2f%%)\n", num_unsolved, 100.0 * num_unsolved / num_secrets);
+    }
+    printf("Average: %.4f guesses, worst case: %d%s\n", average, worst, (num_unsolved != 0) ? " (some unsolved)" : "");
+    printf("Time per game: %.3f ms average, %.3f ms max, %.2f s total\n",
+           result.total_us / 1000.0 / num_secrets,
+           result.max_us / 1000.0,
+           result.elapsed_us / 1e6);
+
+    bool failed = (options.expect_max > 0) && ((worst > options.expect_max) || (num_unsolved != 0));
+    if (options.expect_max > 0)
+    {
+        printf("Expected at most %d guesses: %s\n", options.expect_max, failed ? "FAILED" : "passed");
+    }
+
+    vec_destroy(&result.latencies_us);
+    free(secrets);
+    mm_free_ctx(ctx);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "../mastermind.h"
+#include "../strategy.h"
+#include "../util/vector.h"
+
+typedef struct
+{
+    CodeSize_t num_secrets;
+    uint64_t histogram[MM_MAX_MAX_GUESSES + 2]; // Number of games per number of guesses, last bucket: Not solved
+    uint64_t total_us;                          // Sum of time per game
+    uint64_t max_us;
+    uint64_t elapsed_us;  // Wall time
+    Vector latencies_us;  // Time of each move, uint64_t
+    size_t peak_heap;     // Bytes, only if memory is measured
+} SimResult;
+
+Code_t *sim_get_secrets(MM_Context *ctx, CodeSize_t max_samples, CodeSize_t *out_num_secrets);
+int sim_get_num_threads(int num_threads);
+void sim_play(MM_Context *ctx,
+              const Strategy *strategy,
+              const Code_t *secrets,
+              CodeSize_t num_secrets,
+              int num_threads,
+              bool measure_memory,
+              SimResult *out_result);
+double sim_get_average(const SimResult *result, int *out_worst);
+int run_simulation(int argc, char **argv);
@@ -0,0 +1,171 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "static_set.h"
+#include "../mastermind.h"
+#include "../static_solver.h"
+#include "../util/console.h"
+#include "../util/timer.h"
+
+typedef struct
+{
+    int num_slots;
+    int num_colors;
+    int rules;
+    const char *out_path; // NULL: Table isn't written
+    SsOptions solver;
+} StaticOptions;
+
+static bool parse_options(int argc, char **argv, StaticOptions *out_options)
+{
+    *out_options = (StaticOptions){ .num_slots = 4, .num_colors = 6, .solver = ss_get_default_options() };
+    for (int i = 0; i < argc; i++)
+    {
+        if (i + 1 == argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--slots") == 0)
+        {
+            out_options->num_slots = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--colors") == 0)
+        {
+            out_options->num_colors = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--rules") == 0)
+        {
+            out_options->rules = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--budget") == 0)
+        {
+            out_options->solver.budget_ms = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--threads") == 0)
+        {
+            out_options->solver.num_threads = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--out") == 0)
+        {
+            out_options->out_path = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_hex_code(FILE *file, MM_Context *ctx, Code_t code)
+{
+    int colors[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, code, colors);
+    for (int i = 0; i < mm_get_num_slots(ctx); i++)
+    {
+        fprintf(file, "%x", colors[i]);
+    }
+}
+
+static bool write_table(const SsTable *table, int rules, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    fprintf(file, "%d %d %d\n", mm_get_num_slots(table->ctx), mm_get_num_colors(table->ctx), rules);
+    for (int i = 0; i < table->num_guesses; i++)
+    {
+        print_hex_code(file, table->ctx, table->guesses[i]);
+        fprintf(file, (i + 1 < table->num_guesses) ? " " : "\n");
+    }
+    for (CodeSize_t i = 0; i < table->num_entries; i++)
+    {
+        Code_t secret = table->entries[i].secret;
+        for (int j = 0; j < table->num_guesses; j++)
+        {
+            int b, w;
+            mm_code_to_feedback(table->ctx, mm_get_feedback(table->ctx, table->guesses[j], secret), &b, &w);
+            fprintf(file, "%x%x ", b, w);
+        }
+        fprintf(file, ": ");
+        print_hex_code(file, table->ctx, secret);
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return true;
+}
+
+/*
+ * Summary: Searches the smallest static guess set and optionally writes its table
+ * Returns: Exit code, 1 if no set was found or the table doesn't identify every secret
+ */
+int run_static_set(int argc, char **argv)
+{
+    StaticOptions options;
+    MM_Context *ctx;
+    if (!parse_options(argc, argv, &options))
+    {
+        printf("Usage: --static [--slots n] [--colors n] [--rules n] [--budget ms] [--threads n] [--out file]\n");
+        return 1;
+    }
+    if ((ctx = mm_new_ctx_rules(MM_MAX_MAX_GUESSES, options.num_slots, options.num_colors, options.rules)) == NULL)
+    {
+        printf("Invalid configuration.\n");
+        return 1;
+    }
+
+    SsResult result;
+    uint64_t start = timer_now_us();
+    if (!ss_solve(ctx, &options.solver, &result))
+    {
+        printf("No set found, at most %d codes can be searched.\n", MM_MAX_LOOKUP_CODES);
+        mm_free_ctx(ctx);
+        return 1;
+    }
+    printf("%d guesses identify all %" PRIu64 " secrets (%s, %" PRIu64 " nodes, %.2f s):\n",
+           result.num_guesses,
+           (uint64_t)mm_get_num_codes(ctx),
+           result.is_optimal ? "optimal" : "not proven optimal",
+           result.num_nodes,
+           (timer_now_us() - start) / 1e6);
+    for (int i = 0; i < result.num_guesses; i++)
+    {
+        print_colors(ctx, result.guesses[i]);
+        printf("\n");
+    }
+    if (!result.is_optimal)
+    {
+        printf("Sets of %d to %d guesses weren't ruled out.\n", result.lower_bound, result.num_guesses - 1);
+    }
+
+    // Every secret must be found by its own feedback vector
+    SsTable table  = ss_create_table(ctx, result.num_guesses, result.guesses);
+    bool is_unique = true;
+    for (CodeSize_t i = 0; i < table.num_entries; i++)
+    {
+        Feedback_t feedbacks[MM_MAX_MAX_GUESSES];
+        Code_t secret;
+        for (int j = 0; j < table.num_guesses; j++)
+        {
+            feedbacks[j] = mm_get_feedback(ctx, table.guesses[j], table.entries[i].secret);
+        }
+        is_unique &= ss_lookup(&table, feedbacks, &secret) && (secret == table.entries[i].secret)
+                     && ((i == 0) || (table.entries[i].key != table.entries[i - 1].key));
+    }
+    printf("Lookup table %s.\n", is_unique ? "verified" : "FAILED");
+    if ((options.out_path != NULL) && !write_table(&table, options.rules, options.out_path))
+    {
+        printf("Can't write %s.\n", options.out_path);
+        is_unique = false;
+    }
+
+    ss_destroy_table(&table);
+    mm_free_ctx(ctx);
+    return is_unique ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+ * Table file of a static guess set: The first line holds number of slots, number of colors and rules,
+ * the second line the guesses, each following line a feedback vector and its secret, e.g. "10 02 20 : 0123".
+ * Colors (slot 0 first) and blacks and whites are hex digits, as in game records of the analyzer.
+ */
+
+int run_static_set(int argc, char **argv);
@@ -0,0 +1,327 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "code_set.h"
+
+#define BITMAP_WORDS (CS_CHUNK_SIZE / 64)
+#define BITMAP_BYTES (BITMAP_WORDS * sizeof(uint64_t))
+#define LOW_BITS(code) ((uint16_t)((code) & (CS_CHUNK_SIZE - 1)))
+
+static void free_chunk(Chunk *chunk)
+{
+    free(chunk->data);
+    *chunk = (Chunk){ .type = CS_CHUNK_EMPTY };
+}
+
+static uint32_t count_runs(const Code_t *codes, uint32_t count)
+{
+    uint32_t result = (count != 0) ? 1 : 0;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (codes[i] != codes[i - 1] + 1)
+        {
+            result++;
+        }
+    }
+    return result;
+}
+
+// Builds smallest representation of sorted codes, which all lie within the chunk
+static void build_chunk(Chunk *chunk, const Code_t *codes, uint32_t count)
+{
+    free_chunk(chunk);
+    if (count == 0)
+    {
+        return;
+    }
+
+    uint32_t num_runs  = count_runs(codes, count);
+    size_t array_bytes = count * sizeof(uint16_t);
+    size_t runs_bytes  = num_runs * 2 * sizeof(uint16_t);
+    chunk->cardinality = count;
+
+    if ((runs_bytes <= array_bytes) && (runs_bytes <= BITMAP_BYTES))
+    {
+        uint16_t *runs = malloc(runs_bytes);
+        uint32_t run   = 0;
+        runs[0]        = LOW_BITS(codes[0]);
+        runs[1]        = 0;
+        for (uint32_t i = 1; i < count; i++)
+        {
+            if (codes[i] == codes[i - 1] + 1)
+            {
+                runs[2 * run + 1]++;
+            }
+            else
+            {
+                run++;
+                runs[2 * run]     = LOW_BITS(codes[i]);
+                runs[2 * run + 1] = 0;
+            }
+        }
+        chunk->type     = CS_CHUNK_RUNS;
+        chunk->num_runs = num_runs;
+        chunk->data     = runs;
+    }
+    else if (array_bytes <= BITMAP_BYTES)
+    {
+        uint16_t *values = malloc(array_bytes);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            values[i] = LOW_BITS(codes[i]);
+        }
+        chunk->type = CS_CHUNK_ARRAY;
+        chunk->data = values;
+    }
+    else
+    {
+        uint64_t *bitmap = calloc(BITMAP_WORDS, sizeof(uint64_t));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint16_t value      = LOW_BITS(codes[i]);
+            bitmap[value >> 6] |= (uint64_t)1 << (value & 63);
+        }
+        chunk->type = CS_CHUNK_BITMAP;
+        chunk->data = bitmap;
+    }
+}
+
+// Writes codes of chunk (values offset by base) in ascending order
+static uint32_t decode_chunk(const Chunk *chunk, Code_t base, Code_t *out_codes)
+{
+    uint32_t count = 0;
+    switch (chunk->type)
+    {
+    case CS_CHUNK_EMPTY:
+        break;
+    case CS_CHUNK_ARRAY:
+    {
+        const uint16_t *values = chunk->data;
+        for (; count < chunk->cardinality; count++)
+        {
+            out_codes[count] = base + values[count];
+        }
+        break;
+    }
+    case CS_CHUNK_BITMAP:
+    {
+        const uint64_t *bitmap = chunk->data;
+        for (uint32_t w = 0; w < BITMAP_WORDS; w++)
+        {
+            uint64_t word = bitmap[w];
+            while (word != 0)
+            {
+                out_codes[count++] = base + w * 64 + __builtin_ctzll(word);
+                word &= word - 1;
+            }
+        }
+        break;
+    }
+    case CS_CHUNK_RUNS:
+    {
+        const uint16_t *runs = chunk->data;
+        for (uint32_t r = 0; r < chunk->num_runs; r++)
+        {
+            for (uint32_t v = runs[2 * r]; v <= (uint32_t)runs[2 * r] + runs[2 * r + 1]; v++)
+            {
+                out_codes[count++] = base + v;
+            }
+        }
+        break;
+    }
+    }
+    return count;
+}
+
+static size_t get_chunk_bytes(const Chunk *chunk)
+{
+    switch (chunk->type)
+    {
+    case CS_CHUNK_EMPTY:
+        break;
+    case CS_CHUNK_ARRAY:
+        return chunk->cardinality * sizeof(uint16_t);
+    case CS_CHUNK_BITMAP:
+        return BITMAP_BYTES;
+    case CS_CHUNK_RUNS:
+        return chunk->num_runs * 2 * sizeof(uint16_t);
+    }
+    return 0;
+}
+
+CodeSet *cs_new_full(CodeSize_t num_codes)
+{
+    CodeSet *set = malloc(sizeof(CodeSet));
+    if (set == NULL)
+    {
+        return NULL;
+    }
+    set->cardinality = num_codes;
+    set->num_chunks  = (num_codes + CS_CHUNK_SIZE - 1) / CS_CHUNK_SIZE;
+    set->chunks      = calloc(set->num_chunks, sizeof(Chunk)); // CS_CHUNK_EMPTY, so a partial set can be freed
+    if (set->chunks == NULL)
+    {
+        free(set);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < set->num_chunks; i++)
+    {
+        uint32_t count = (i == set->num_chunks - 1) ? num_codes - i * CS_CHUNK_SIZE : CS_CHUNK_SIZE;
+        uint16_t *runs = malloc(2 * sizeof(uint16_t));
+        if (runs == NULL)
+        {
+            cs_free(set);
+            return NULL;
+        }
+        runs[0]        = 0;
+        runs[1]        = count - 1;
+        set->chunks[i] = (Chunk){ .type = CS_CHUNK_RUNS, .cardinality = count, .num_runs = 1, .data = runs };
+    }
+    return set;
+}
+
+CodeSet *cs_copy(const CodeSet *set)
+{
+    CodeSet *result = malloc(sizeof(CodeSet));
+    *result         = *set;
+    result->chunks  = malloc(set->num_chunks * sizeof(Chunk));
+    for (size_t i = 0; i < set->num_chunks; i++)
+    {
+        size_t bytes      = get_chunk_bytes(&set->chunks[i]);
+        result->chunks[i] = set->chunks[i];
+        if (bytes != 0)
+        {
+            result->chunks[i].data = malloc(bytes);
+            memcpy(result->chunks[i].data, set->chunks[i].data, bytes);
+        }
+    }
+    return result;
+}
+
+void cs_free(CodeSet *set)
+{
+    if (set == NULL)
+    {
+        return;
+    }
+    for (size_t i = 0; i < set->num_chunks; i++)
+    {
+        free(set->chunks[i].data);
+    }
+    free(set->chunks);
+    free(set);
+}
+
+bool cs_contains(const CodeSet *set, Code_t code)
+{
+    size_t index = code >> CS_CHUNK_BITS;
+    if (index >= set->num_chunks)
+    {
+        return false;
+    }
+    const Chunk *chunk = &set->chunks[index];
+    uint16_t value     = code & (CS_CHUNK_SIZE - 1);
+
+    switch (chunk->type)
+    {
+    case CS_CHUNK_EMPTY:
+        return false;
+    case CS_CHUNK_BITMAP:
+        return (((const uint64_t *)chunk->data)[value >> 6] >> (value & 63)) & 1;
+    case CS_CHUNK_ARRAY:
+    {
+        const uint16_t *values = chunk->data;
+        uint32_t low           = 0;
+        uint32_t high          = chunk->cardinality;
+        while (low < high)
+        {
+            uint32_t mid = (low + high) / 2;
+            if (values[mid] < value)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return (low < chunk->cardinality) && (values[low] == value);
+    }
+    case CS_CHUNK_RUNS:
+    {
+        // Find last run starting at or before value
+        const uint16_t *runs = chunk->data;
+        uint32_t low         = 0;
+        uint32_t high        = chunk->num_runs;
+        while (low < high)
+        {
+            uint32_t mid = (low + high) / 2;
+            if (runs[2 * mid] <= value)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return (low != 0) && (value <= (uint32_t)runs[2 * (low - 1)] + runs[2 * (low - 1) + 1]);
+    }
+    }
+    return false;
+}
+
+CodeSize_t cs_count(const CodeSet *set)
+{
+    return set->cardinality;
+}
+
+// Heap memory in bytes
+size_t cs_get_memory(const CodeSet *set)
+{
+    size_t result = sizeof(CodeSet) + set->num_chunks * sizeof(Chunk);
+    for (size_t i = 0; i < set->num_chunks; i++)
+    {
+        result += get_chunk_bytes(&set->chunks[i]);
+    }
+    return result;
+}
+
+size_t cs_get_num_chunks(const CodeSet *set)
+{
+    return set->num_chunks;
+}
+
+uint32_t cs_get_chunk_count(const CodeSet *set, size_t chunk)
+{
+    return set->chunks[chunk].cardinality;
+}
+
+// out_codes must hold CS_CHUNK_SIZE codes, chunks are decoded straight into it (no scratch on the stack of worker threads)
+uint32_t cs_get_chunk_codes(const CodeSet *set, size_t chunk, Code_t *out_codes)
+{
+    return decode_chunk(&set->chunks[chunk], (Code_t)chunk << CS_CHUNK_BITS, out_codes);
+}
+
+// Replaces content of chunk by codes, which must be ascending and lie within chunk
+void cs_set_chunk_codes(CodeSet *set, size_t chunk, const Code_t *codes, uint32_t num_codes)
+{
+    set->cardinality -= set->chunks[chunk].cardinality;
+    build_chunk(&set->chunks[chunk], codes, num_codes);
+    set->cardinality += num_codes;
+}
+
+// Writes all codes in ascending order
+CodeSize_t cs_get_codes(const CodeSet *set, Code_t *out_codes)
+{
+    CodeSize_t count = 0;
+    for (size_t i = 0; i < set->num_chunks; i++)
+    {
+        if (set->chunks[i].type != CS_CHUNK_EMPTY)
+        {
+            count += cs_get_chunk_codes(set, i, out_codes + count);
+        }
+    }
+    return count;
+}
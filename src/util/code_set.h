@@ -0,0 +1,50 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "../mastermind.h"
+
+/*
+ * Roaring-style compressed set of codes: The code space is split into chunks of 2^16 codes,
+ * each chunk is stored as sorted array, bitmap or list of runs, whichever is smallest.
+ * Empty chunks don't hold any memory.
+ */
+
+#define CS_CHUNK_BITS 16
+#define CS_CHUNK_SIZE (1u << CS_CHUNK_BITS)
+
+typedef enum
+{
+    CS_CHUNK_EMPTY,
+    CS_CHUNK_ARRAY,  // Sorted uint16_t values
+    CS_CHUNK_BITMAP, // CS_CHUNK_SIZE bits
+    CS_CHUNK_RUNS    // Pairs of uint16_t (start, length - 1)
+} ChunkType;
+
+typedef struct
+{
+    ChunkType type;
+    uint32_t cardinality;
+    uint32_t num_runs;
+    void *data;
+} Chunk;
+
+typedef struct
+{
+    CodeSize_t cardinality;
+    size_t num_chunks;
+    Chunk *chunks;
+} CodeSet;
+
+CodeSet *cs_new_full(CodeSize_t num_codes);
+CodeSet *cs_copy(const CodeSet *set);
+void cs_free(CodeSet *set);
+
+bool cs_contains(const CodeSet *set, Code_t code);
+CodeSize_t cs_count(const CodeSet *set);
+size_t cs_get_memory(const CodeSet *set);
+
+size_t cs_get_num_chunks(const CodeSet *set);
+uint32_t cs_get_chunk_count(const CodeSet *set, size_t chunk);
+uint32_t cs_get_chunk_codes(const CodeSet *set, size_t chunk, Code_t *out_codes);
+void cs_set_chunk_codes(CodeSet *set, size_t chunk, const Code_t *codes, uint32_t num_codes);
+CodeSize_t cs_get_codes(const CodeSet *set, Code_t *out_codes);
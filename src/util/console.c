@@ -4,6 +4,7 @@
 #include <readline/readline.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <math.h>
 
 #include "console.h"
 #include "../multiplayer/protocol.h"
@@ -13,11 +14,13 @@
 
 typedef struct
 {
-    const char *str;
-    const char *col;
+    char str[7];
+    char col[16];
 } Color;
 
-static const Color colors[] = {
+#define NUM_NAMED_COLORS 8
+
+static Color colors[MM_MAX_NUM_COLORS] = {
     { "Orange", "\033[38;5;208m" },
     { " Red  ", "\033[38;5;196m" },
     { "Yellow", "\033[38;5;226m" },
@@ -28,6 +31,51 @@ static const Color colors[] = {
     { " Pink ", "\033[38;5;13m" }
 };
 
+static bool palette_generated = false;
+
+/*
+ * Summary: Colors beyond the named ones are labeled with letters not used by any named color
+ *     and spread over the hue circle of the 6x6x6 ANSI color cube by the golden angle
+ */
+static void generate_palette()
+{
+    if (palette_generated)
+    {
+        return;
+    }
+    palette_generated = true;
+
+    char letter = 'a';
+    for (int i = NUM_NAMED_COLORS; i < MM_MAX_NUM_COLORS; i++)
+    {
+        bool used = true;
+        while (used)
+        {
+            used = false;
+            for (int j = 0; j < i; j++)
+            {
+                if (to_lower(*first_char(colors[j].str)) == letter)
+                {
+                    used = true;
+                    letter++;
+                    break;
+                }
+            }
+        }
+
+        double hue       = fmod(0.25 + (i - NUM_NAMED_COLORS) * 0.618033988749895, 1.0) * 6;
+        double x         = 1 - fabs(fmod(hue, 2) - 1);
+        double rgb[6][3] = { { 1, x, 0 }, { x, 1, 0 }, { 0, 1, x }, { 0, x, 1 }, { x, 0, 1 }, { 1, 0, x } };
+        double *c        = rgb[(int)hue];
+        snprintf(colors[i].str, sizeof(colors[i].str), "  %c   ", to_upper(letter));
+        snprintf(colors[i].col,
+                 sizeof(colors[i].col),
+                 "\033[38;5;%dm",
+                 16 + 36 * (int)(c[0] * 5 + 0.5) + 6 * (int)(c[1] * 5 + 0.5) + (int)(c[2] * 5 + 0.5));
+        letter++;
+    }
+}
+
 #define BLK    "\033[38;5;0m"
 #define WHT    "\033[38;5;15m"
 #define BLK_BG "\033[48;5;0m"
@@ -57,7 +105,7 @@ void print_match_end_message(MM_Match *match, Code_t solution, bool show_turns)
         printf(" ~ ~\n");
         if (mm_is_solution_counting_enabled(match) && mm_get_remaining_solutions(match) > 1)
         {
-            printf("You won by luck, there were %d solutions still possible (including your guess).\n", mm_get_remaining_solutions(match));
+            printf("You won by luck, there were %" PRIu64 " solutions still possible (including your guess).\n", (uint64_t)mm_get_remaining_solutions(match));
         }
     }
     else
@@ -82,6 +130,7 @@ char *readline_fmt(const char *fmt, ...)
 
 bool get_colors_from_string(MM_Context *ctx, const char *string, Code_t *out_code)
 {
+    generate_palette();
     if ((int)strlen(string) == mm_get_num_slots(ctx))
     {
         int input_colors[MM_MAX_NUM_SLOTS];
@@ -101,6 +150,10 @@ bool get_colors_from_string(MM_Context *ctx, const char *string, Code_t *out_cod
                 return false;
             }
         }
+        if (!mm_is_valid_colors(ctx, input_colors))
+        {
+            return false;
+        }
         *out_code = mm_colors_to_code(ctx, input_colors);
         return true;
     }
@@ -112,6 +165,7 @@ bool get_colors_from_string(MM_Context *ctx, const char *string, Code_t *out_cod
 
 bool read_colors(MM_Context *ctx, int turn, Code_t *out_code)
 {
+    generate_palette();
     StringBuilder pb = strb_create();
     if (turn != -1)
     {
@@ -155,11 +209,14 @@ void print_colors(MM_Context *ctx, Code_t input)
 
 char *get_colors_string(MM_Context *ctx, Code_t input)
 {
+    generate_palette();
     StringBuilder builder = strb_create();
     strb_append(&builder, " ");
+    int code_colors[MM_MAX_NUM_SLOTS];
+    mm_code_to_colors(ctx, input, code_colors);
     for (int i = 0; i < mm_get_num_slots(ctx); i++)
     {
-        int col = mm_get_color_at_pos(mm_get_num_colors(ctx), input, i);
+        int col = code_colors[i];
         strb_append(&builder, "%s%s" RST "  ", colors[col].col, colors[col].str);
     }
     return strb_to_str(&builder);
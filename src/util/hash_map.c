@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "hash_map.h"
+
+#define HASHMAP_START_BUCKETS 64
+#define HASHMAP_MAX_LOAD      0.5
+
+// Entry layout: [used flag][key][value], value is aligned to 8 bytes
+#define ALIGN(x)          (((x) + 7) & ~(size_t)7)
+#define KEY_OFFSET        1
+#define VALUE_OFFSET(map) (ALIGN(KEY_OFFSET + (map)->key_size))
+
+static uint64_t hash_bytes(const void *key, size_t size)
+{
+    // FNV-1a
+    uint64_t hash        = 14695981039346656037ULL;
+    const uint8_t *bytes = key;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint8_t *get_entry(const HashMap *map, size_t index)
+{
+    return (uint8_t *)map->buffer + index * map->entry_size;
+}
+
+// Returns slot of key or the empty slot where it would be inserted
+static uint8_t *find_entry(const HashMap *map, const void *key)
+{
+    size_t index = hash_bytes(key, map->key_size) & (map->num_buckets - 1);
+    while (true)
+    {
+        uint8_t *entry = get_entry(map, index);
+        if (!entry[0] || (memcmp(entry + KEY_OFFSET, key, map->key_size) == 0))
+        {
+            return entry;
+        }
+        index = (index + 1) & (map->num_buckets - 1);
+    }
+}
+
+static void grow(HashMap *map)
+{
+    HashMap old      = *map;
+    map->num_buckets = old.num_buckets * 2;
+    map->buffer      = calloc(map->num_buckets, map->entry_size);
+    for (size_t i = 0; i < old.num_buckets; i++)
+    {
+        uint8_t *entry = get_entry(&old, i);
+        if (entry[0])
+        {
+            memcpy(find_entry(map, entry + KEY_OFFSET), entry, map->entry_size);
+        }
+    }
+    free(old.buffer);
+}
+
+HashMap hm_create(size_t key_size, size_t value_size)
+{
+    HashMap result = {
+        .key_size    = key_size,
+        .value_size  = value_size,
+        .elem_count  = 0,
+        .num_buckets = HASHMAP_START_BUCKETS
+    };
+    result.entry_size = ALIGN(VALUE_OFFSET(&result) + value_size);
+    result.buffer     = calloc(result.num_buckets, result.entry_size);
+    return result;
+}
+
+void hm_destroy(HashMap *map)
+{
+    free(map->buffer);
+}
+
+void hm_clear(HashMap *map)
+{
+    memset(map->buffer, 0, map->num_buckets * map->entry_size);
+    map->elem_count = 0;
+}
+
+void *hm_get(const HashMap *map, const void *key)
+{
+    uint8_t *entry = find_entry(map, key);
+    if (!entry[0])
+    {
+        return NULL;
+    }
+    return entry + VALUE_OFFSET(map);
+}
+
+void *hm_put(HashMap *map, const void *key, bool *out_inserted)
+{
+    if (map->elem_count + 1 > map->num_buckets * HASHMAP_MAX_LOAD)
+    {
+        grow(map);
+    }
+    uint8_t *entry = find_entry(map, key);
+    bool inserted  = !entry[0];
+    if (inserted)
+    {
+        entry[0] = 1;
+        memcpy(entry + KEY_OFFSET, key, map->key_size);
+        map->elem_count++;
+    }
+    if (out_inserted != NULL)
+    {
+        *out_inserted = inserted;
+    }
+    return entry + VALUE_OFFSET(map);
+}
+
+size_t hm_count(const HashMap *map)
+{
+    return map->elem_count;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * Open addressing hash map with fixed-size keys and values.
+ * Never save pointers to values when there are elements
+ * inserted into the map! It can be realloc'ed!
+ */
+
+typedef struct
+{
+    size_t key_size;
+    size_t value_size;
+    size_t entry_size;
+    size_t elem_count;
+    size_t num_buckets;
+    void *buffer;
+} HashMap;
+
+HashMap hm_create(size_t key_size, size_t value_size);
+void hm_destroy(HashMap *map);
+void hm_clear(HashMap *map);
+
+// Returns NULL if key is not in map
+void *hm_get(const HashMap *map, const void *key);
+// Inserts zeroed value if key is not in map
+void *hm_put(HashMap *map, const void *key, bool *out_inserted);
+
+size_t hm_count(const HashMap *map);
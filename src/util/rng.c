@@ -0,0 +1,90 @@
+#define _DEFAULT_SOURCE
+#include <time.h>
+#include <unistd.h>
+
+#include "rng.h"
+
+static uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// High 64 bits of a * b, from 32 bit halves (no 128 bit integers in C99)
+static uint64_t mul_high(uint64_t a, uint64_t b)
+{
+    uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    uint64_t lo   = a_lo * b_lo;
+    uint64_t mid1 = a_hi * b_lo + (lo >> 32);
+    uint64_t mid2 = a_lo * b_hi + (mid1 & 0xFFFFFFFF);
+    return a_hi * b_hi + (mid1 >> 32) + (mid2 >> 32);
+}
+
+// State is expanded by splitmix64, so that similar seeds (e.g. consecutive ones) give unrelated streams
+void rng_seed(Rng *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+uint64_t rng_next(Rng *rng)
+{
+    uint64_t *s     = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t      = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/*
+ * Summary: Uniform integer in [0, bound) by Lemire's multiply and shift, without the bias of a modulo:
+ *     Draws whose low product falls below 2^64 mod bound are rejected, which is rare for small bounds
+ */
+uint64_t rng_below(Rng *rng, uint64_t bound)
+{
+    if (bound <= 1)
+    {
+        return 0;
+    }
+    uint64_t threshold = (0 - bound) % bound;
+    uint64_t x;
+    do
+    {
+        x = rng_next(rng);
+    } while (x * bound < threshold);
+    return mul_high(x, bound);
+}
+
+// Uniform double in (0, 1) from the upper 53 bits, never 0 so that its logarithm is finite
+double rng_uniform(Rng *rng)
+{
+    return ((rng_next(rng) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+// Seed that differs between runs and between calls, for games that need not be reproduced
+uint64_t rng_get_entropy()
+{
+    static uint64_t counter;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t state = ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec) ^ ((uint64_t)getpid() << 32);
+
+    state += __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED) * 0x9E3779B97F4A7C15ull;
+    return splitmix64(&state);
+}
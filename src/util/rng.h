@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Small seedable pseudo random number generator (xoshiro256**). Each context, match or worker
+ * owns its state, so threads draw without locks and a game is reproduced from its seed.
+ */
+
+typedef struct
+{
+    uint64_t s[4];
+} Rng;
+
+void rng_seed(Rng *rng, uint64_t seed);
+uint64_t rng_next(Rng *rng);
+uint64_t rng_below(Rng *rng, uint64_t bound);
+double rng_uniform(Rng *rng);
+uint64_t rng_get_entropy();
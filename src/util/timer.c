@@ -0,0 +1,29 @@
+#define _DEFAULT_SOURCE
+#include <time.h>
+
+#include "timer.h"
+
+#define NO_DEADLINE UINT64_MAX
+
+// Monotonic time in microseconds
+uint64_t timer_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// A budget <= 0 means that there is no deadline
+uint64_t timer_deadline_us(int budget_ms)
+{
+    if (budget_ms <= 0)
+    {
+        return NO_DEADLINE;
+    }
+    return timer_now_us() + (uint64_t)budget_ms * 1000;
+}
+
+bool timer_expired(uint64_t deadline_us)
+{
+    return (deadline_us != NO_DEADLINE) && (timer_now_us() >= deadline_us);
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+uint64_t timer_now_us();
+uint64_t timer_deadline_us(int budget_ms);
+bool timer_expired(uint64_t deadline_us);